@@ -0,0 +1,523 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "compress.h"
+
+static const double Pi = 3.14159265359;
+
+// Lubachevsky-Stillinger compression: the polygons move ballistically and spin in a fixed container,
+// while their size grows as 1 + COMPRESS_GROWTH * t, until the packing jams. Times of impact are found
+// by conservative advancement, and events are processed in time order from a calendar. Particles are
+// only brought up to date when involved in an event, and only look for partners in neighbouring cells.
+
+enum {CELL_EVENT = -1, WALL_EVENT = -2, CHECK_EVENT = -3};
+
+typedef struct
+{
+	Point center, velocity; // at 'time'
+	double angle, spin;
+	double time;
+	int cell;
+	int version;   // incremented on each velocity change
+	int scheduled; // incremented on each new prediction
+} Particle;
+
+typedef struct
+{
+	double time;
+	int i, other;           // 'other' is a particle, or one of the event kinds above
+	int scheduled, version; // of 'i' and 'other' at prediction time
+} Event;
+
+typedef struct
+{
+	int n_particles;
+	Particle *particles;
+	Event *heap; // binary min-heap on time, superseded events being skipped when popped
+	int heapLength, heapCapacity;
+	Box container;
+	int nx; // cells per side
+	double cellSide;
+	int *cellHead, *next, *prev; // doubly linked lists of the particles of each cell
+	double radius, inertia;      // at size 1, for unit masses
+	Point directions[N_SIDES];   // of the vertices, at angle 0
+} Simulation;
+
+typedef struct
+{
+	double distance;
+	Point normal; // unit, from the first particle (or the wall) to the second
+	Point point;
+	Point center1, center2;
+} Contact;
+
+static double sizeAt(double t)
+{
+	return 1. + COMPRESS_GROWTH * t;
+}
+
+static Point centerAt(const Particle *p, double t)
+{
+	return (Point) {p->center.x + p->velocity.x * (t - p->time), p->center.y + p->velocity.y * (t - p->time)};
+}
+
+static void shapeAt(const Simulation *sim, const Particle *p, double t, Point points[N_SIDES])
+{
+	const Point c = centerAt(p, t);
+	const double angle = p->angle + p->spin * (t - p->time), r = sizeAt(t) * sim->radius;
+	const double co = r * cos(angle), si = r * sin(angle);
+	for (int k = 0; k < N_SIDES; ++k) {
+		const Point *u = sim->directions + k;
+		points[k] = (Point) {c.x + co * u->x - si * u->y, c.y + si * u->x + co * u->y};
+	}
+}
+
+static void advance(Particle *p, double t)
+{
+	p->center = centerAt(p, t);
+	p->angle += p->spin * (t - p->time);
+	p->time = t;
+}
+
+/////////////////////////////////////////////
+// Event calendar:
+/////////////////////////////////////////////
+
+static void siftDown(Event *heap, int length, int k)
+{
+	for (;;) {
+		int child = 2 * k + 1;
+		if (child >= length)
+			return;
+		if (child + 1 < length && heap[child + 1].time < heap[child].time)
+			++child;
+		if (heap[k].time <= heap[child].time)
+			return;
+		const Event tmp = heap[k];
+		heap[k] = heap[child];
+		heap[child] = tmp;
+		k = child;
+	}
+}
+
+// Superseded events are dropped once they outnumber the particles, so that the heap stays O(n).
+static void push(Simulation *sim, Event event)
+{
+	if (sim->heapLength == sim->heapCapacity) {
+		int length = 0;
+		for (int k = 0; k < sim->heapLength; ++k) {
+			if (sim->heap[k].scheduled == sim->particles[sim->heap[k].i].scheduled)
+				sim->heap[length++] = sim->heap[k];
+		}
+		sim->heapLength = length;
+		for (int k = length / 2 - 1; k >= 0; --k)
+			siftDown(sim->heap, length, k);
+		if (2 * length > sim->heapCapacity) {
+			sim->heapCapacity *= 2;
+			sim->heap = (Event*) realloc(sim->heap, sim->heapCapacity * sizeof(Event));
+		}
+	}
+	int k = sim->heapLength++;
+	sim->heap[k] = event;
+	while (k > 0 && sim->heap[(k-1) / 2].time > sim->heap[k].time) {
+		const Event tmp = sim->heap[k];
+		sim->heap[k] = sim->heap[(k-1) / 2];
+		sim->heap[(k-1) / 2] = tmp;
+		k = (k-1) / 2;
+	}
+}
+
+static Event pop(Simulation *sim)
+{
+	const Event top = sim->heap[0];
+	sim->heap[0] = sim->heap[--sim->heapLength];
+	siftDown(sim->heap, sim->heapLength, 0);
+	return top;
+}
+
+/////////////////////////////////////////////
+// Cell lists:
+/////////////////////////////////////////////
+
+static int cellOf(const Simulation *sim, const Point *p)
+{
+	const int cx = (int) fmin(fmax(floor((p->x - sim->container.xmin) / sim->cellSide), 0.), sim->nx - 1);
+	const int cy = (int) fmin(fmax(floor((p->y - sim->container.ymin) / sim->cellSide), 0.), sim->nx - 1);
+	return cy * sim->nx + cx;
+}
+
+static void insertInCell(Simulation *sim, int i, int cell)
+{
+	sim->particles[i].cell = cell;
+	sim->prev[i] = -1;
+	sim->next[i] = sim->cellHead[cell];
+	if (sim->cellHead[cell] >= 0)
+		sim->prev[sim->cellHead[cell]] = i;
+	sim->cellHead[cell] = i;
+}
+
+static void removeFromCell(Simulation *sim, int i)
+{
+	if (sim->prev[i] >= 0)
+		sim->next[sim->prev[i]] = sim->next[i];
+	else
+		sim->cellHead[sim->particles[i].cell] = sim->next[i];
+	if (sim->next[i] >= 0)
+		sim->prev[sim->next[i]] = sim->prev[i];
+}
+
+// Time left before the center leaves its cell, along x (axis 0) and y (axis 1). Border cells
+// are never left through the container sides, walls being hit first.
+static double cellExit(const Simulation *sim, const Particle *p, int axis)
+{
+	const int c = axis ? p->cell / sim->nx : p->cell % sim->nx;
+	const double v = axis ? p->velocity.y : p->velocity.x, x = axis ? p->center.y : p->center.x;
+	const double low = (axis ? sim->container.ymin : sim->container.xmin) + c * sim->cellSide;
+	if (v > 0. && c < sim->nx - 1)
+		return fmax((low + sim->cellSide - x) / v, 0.);
+	if (v < 0. && c > 0)
+		return fmax((low - x) / v, 0.);
+	return INFINITY;
+}
+
+static void changeCell(Simulation *sim, int i)
+{
+	Particle *p = sim->particles + i;
+	const bool alongY = cellExit(sim, p, 1) < cellExit(sim, p, 0);
+	const double v = alongY ? p->velocity.y : p->velocity.x;
+	const int step = (v > 0. ? 1 : -1) * (alongY ? sim->nx : 1);
+	removeFromCell(sim, i);
+	insertInCell(sim, i, p->cell + step);
+}
+
+/////////////////////////////////////////////
+// Contacts:
+/////////////////////////////////////////////
+
+static void pairContact(const Simulation *sim, const Particle *a, const Particle *b, double t, Contact *c)
+{
+	Point pa[N_SIDES], pb[N_SIDES], A, B;
+	shapeAt(sim, a, t, pa);
+	shapeAt(sim, b, t, pb);
+	c->distance = polygonsDistance(pa, N_SIDES, pb, N_SIDES, &A, &B);
+	const double d = fmax(c->distance, EPSILON);
+	c->normal = (Point) {(B.x - A.x) / d, (B.y - A.y) / d};
+	c->point = (Point) {(A.x + B.x) / 2., (A.y + B.y) / 2.};
+	c->center1 = centerAt(a, t);
+	c->center2 = centerAt(b, t);
+}
+
+// Closest vertex to the container sides.
+static void wallContact(const Simulation *sim, const Particle *p, double t, Contact *c)
+{
+	Point points[N_SIDES];
+	shapeAt(sim, p, t, points);
+	const Box *box = &(sim->container);
+	c->distance = INFINITY;
+	for (int k = 0; k < N_SIDES; ++k) {
+		const double gaps[4] = {points[k].x - box->xmin, box->xmax - points[k].x, points[k].y - box->ymin, box->ymax - points[k].y};
+		const Point normals[4] = {{1., 0.}, {-1., 0.}, {0., 1.}, {0., -1.}};
+		for (int w = 0; w < 4; ++w) {
+			if (gaps[w] < c->distance) {
+				c->distance = gaps[w];
+				c->normal = normals[w];
+				c->point = points[k];
+			}
+		}
+	}
+	c->center2 = centerAt(p, t);
+}
+
+// Velocity of a point of 'p', including the growth of its size.
+static Point pointVelocity(const Particle *p, const Point *center, const Point *point, double t)
+{
+	const double rx = point->x - center->x, ry = point->y - center->y, growth = COMPRESS_GROWTH / sizeAt(t);
+	return (Point) {p->velocity.x - p->spin * ry + growth * rx, p->velocity.y + p->spin * rx + growth * ry};
+}
+
+// Normal speed of the second particle away from the first one (NULL for a wall) at the contact.
+static double separationSpeed(const Particle *a, const Particle *b, const Contact *c, double t)
+{
+	const Point vb = pointVelocity(b, &(c->center2), &(c->point), t);
+	const Point va = a ? pointVelocity(a, &(c->center1), &(c->point), t) : (Point) {0., 0.};
+	return (vb.x - va.x) * c->normal.x + (vb.y - va.y) * c->normal.y;
+}
+
+static double cross(const Point *r, const Point *n)
+{
+	return r->x * n->y - r->y * n->x;
+}
+
+// Elastic impulse along the normal, reversing the separation speed. The growth is part of it,
+// hence particles leave faster than they came and kinetic energy increases.
+static void collide(const Simulation *sim, Particle *a, Particle *b, const Contact *c, double t)
+{
+	const double speed = separationSpeed(a, b, c, t);
+	if (speed >= 0.)
+		return;
+	const double inertia = sim->inertia * sizeAt(t) * sizeAt(t);
+	const Point rb = {c->point.x - c->center2.x, c->point.y - c->center2.y};
+	const double cb = cross(&rb, &(c->normal));
+	double K = 1. + cb * cb / inertia, ca = 0.;
+	if (a) {
+		const Point ra = {c->point.x - c->center1.x, c->point.y - c->center1.y};
+		ca = cross(&ra, &(c->normal));
+		K += 1. + ca * ca / inertia;
+	}
+	const double J = -2. * speed / K;
+	b->velocity.x += J * c->normal.x;
+	b->velocity.y += J * c->normal.y;
+	b->spin += J * cb / inertia;
+	if (a) {
+		a->velocity.x -= J * c->normal.x;
+		a->velocity.y -= J * c->normal.y;
+		a->spin -= J * ca / inertia;
+	}
+}
+
+/////////////////////////////////////////////
+// Predictions:
+/////////////////////////////////////////////
+
+// First time from t on at which the circumscribed circles of the particles touch, or t if they already
+// overlap. Exact: their distance is quadratic in time, and their radii are linear.
+static double circlesImpact(const Simulation *sim, const Particle *a, const Particle *b, double t)
+{
+	const Point ca = centerAt(a, t), cb = centerAt(b, t);
+	const Point D = {cb.x - ca.x, cb.y - ca.y}, V = {b->velocity.x - a->velocity.x, b->velocity.y - a->velocity.y};
+	const double R = 2. * sizeAt(t) * sim->radius + COMPRESS_GAP, G = 2. * COMPRESS_GROWTH * sim->radius;
+	const double qa = norm2(&V) - G * G, qb = D.x * V.x + D.y * V.y - R * G, qc = norm2(&D) - R * R;
+	if (qc <= 0.)
+		return t;
+	// Smallest positive root of qa.x² + 2qb.x + qc, qc being positive:
+	if (qa == 0.)
+		return qb < 0. ? t - qc / (2. * qb) : INFINITY;
+	const double delta = qb * qb - qa * qc;
+	if (delta < 0.)
+		return INFINITY;
+	const double root = qb < 0. ? qc / (-qb + sqrt(delta)) : (qa < 0. ? (-qb - sqrt(delta)) / qa : INFINITY);
+	return root >= 0. ? t + root : INFINITY;
+}
+
+// Earliest time in [t, tmax) at which the particles come within COMPRESS_GAP of each other (of the
+// container sides if 'a' is NULL) while approaching. By conservative advancement: they cannot
+// close faster than 'bound', and each step leaves at least half their distance. Returns INFINITY
+// if there is none, and clears 'converged' if the steps ran out, then returning the resume time.
+static double impact(const Simulation *sim, const Particle *a, const Particle *b, double t, double tmax, bool *converged)
+{
+	const Point dv = {b->velocity.x - (a ? a->velocity.x : 0.), b->velocity.y - (a ? a->velocity.y : 0.)};
+	const double spins = fabs(b->spin) + (a ? fabs(a->spin) : 0.);
+	const double bound = sqrt(norm2(&dv)) + (spins * sizeAt(tmax) + (a ? 2. : 1.) * COMPRESS_GROWTH) * sim->radius;
+	*converged = true;
+	if (a) {
+		t = circlesImpact(sim, a, b, t);
+		if (t >= tmax)
+			return INFINITY;
+	}
+	for (int step = 0; step < COMPRESS_CA_STEPS && t < tmax; ++step) {
+		Contact c;
+		if (a)
+			pairContact(sim, a, b, t, &c);
+		else
+			wallContact(sim, b, t, &c);
+		if (c.distance <= COMPRESS_GAP && separationSpeed(a, b, &c, t) < 0.)
+			return t;
+		t += c.distance > COMPRESS_GAP ? (c.distance - COMPRESS_GAP / 2.) / bound : fmax(c.distance, COMPRESS_GAP / 4.) / (2. * bound);
+	}
+	if (t >= tmax)
+		return INFINITY;
+	*converged = false;
+	return t;
+}
+
+// Schedules the next event of particle 'i', which must be up to date at time t.
+static void predict(Simulation *sim, int i, double t)
+{
+	Particle *p = sim->particles + i;
+	++p->scheduled;
+	Event best = {t + COMPRESS_HORIZON, i, CHECK_EVENT, p->scheduled, 0};
+	const double exit = t + fmin(cellExit(sim, p, 0), cellExit(sim, p, 1));
+	if (exit < best.time) {
+		best.time = exit;
+		best.other = CELL_EVENT;
+	}
+
+	bool converged = true;
+	const double tw = impact(sim, NULL, p, t, best.time, &converged);
+	if (tw < best.time) {
+		best.time = tw;
+		best.other = converged ? WALL_EVENT : CHECK_EVENT;
+	}
+
+	const int cx = p->cell % sim->nx, cy = p->cell / sim->nx;
+	for (int y = cy - 1; y <= cy + 1; ++y) {
+		for (int x = cx - 1; x <= cx + 1; ++x) {
+			if (x < 0 || y < 0 || x >= sim->nx || y >= sim->nx)
+				continue;
+			for (int j = sim->cellHead[y * sim->nx + x]; j >= 0; j = sim->next[j]) {
+				if (j == i)
+					continue;
+				const double tj = impact(sim, p, sim->particles + j, t, best.time, &converged);
+				if (tj < best.time) {
+					best.time = tj;
+					best.other = converged ? j : CHECK_EVENT;
+					best.version = sim->particles[j].version;
+				}
+			}
+		}
+	}
+	push(sim, best);
+}
+
+// Brings all particles up to date, scales their velocities back to the given kinetic energy,
+// and schedules everything anew.
+static void thermostat(Simulation *sim, double t, double energy)
+{
+	const double inertia = sim->inertia * sizeAt(t) * sizeAt(t);
+	double current = 0.;
+	for (int i = 0; i < sim->n_particles; ++i) {
+		Particle *p = sim->particles + i;
+		advance(p, t);
+		current += norm2(&(p->velocity)) + inertia * p->spin * p->spin;
+	}
+	const double scale = current > 0. ? sqrt(energy / current) : 1.;
+	for (int i = 0; i < sim->n_particles; ++i) {
+		Particle *p = sim->particles + i;
+		p->velocity.x *= scale;
+		p->velocity.y *= scale;
+		p->spin *= scale;
+		++p->version;
+	}
+	for (int i = 0; i < sim->n_particles; ++i)
+		predict(sim, i, t);
+}
+
+/////////////////////////////////////////////
+// Engine:
+/////////////////////////////////////////////
+
+// Event-driven compression of 'sol', in its current square container. Each collision or cell change
+// counts as one iteration. Every COMPRESS_PERIOD * n_polygons of them, kinetic energy is restored,
+// and the simulation stops if jammed: the size grew by less than COMPRESS_JAM_TOL meanwhile. The final configuration is scaled back to unit area polygons, and
+// kept if valid and better. Returns true if the solution has been improved.
+bool optimize_compress(Engine *engine, Solution *sol, int iterationNumber)
+{
+	rng_type *rng = &engine->rng;
+	const int n_polygons = sol->n_polygons;
+	Polygon *polArray = sol->polArray;
+	if (!checkConfiguration(polArray, n_polygons)) {
+		printf("optimize_compress() needs a valid configuration.\n");
+		return false;
+	}
+
+	Simulation sim = {0};
+	sim.n_particles = n_polygons;
+	sim.radius = getRadius();
+	sim.inertia = sim.radius * sim.radius * (2. + cos(2. * Pi / N_SIDES)) / 6.;
+	for (int k = 0; k < N_SIDES; ++k)
+		sim.directions[k] = (Point) {cos((k + 0.5) * 2. * Pi / N_SIDES), sin((k + 0.5) * 2. * Pi / N_SIDES)};
+	const Box b = findBoundary(polArray, n_polygons);
+	const double side = fmax(b.xmax - b.xmin, b.ymax - b.ymin);
+	sim.container = (Box) {b.xmin, b.xmin + side, b.ymin, b.ymin + side};
+	// Cells stay wider than the polygons, whose total area cannot exceed the container's:
+	const double maxSize = side / sqrt(n_polygons);
+	sim.nx = (int) fmax(floor(side / (maxSize * sqrt(getDiam2()))), 1.);
+	sim.cellSide = side / sim.nx;
+	sim.particles = (Particle*) calloc(n_polygons, sizeof(Particle));
+	sim.cellHead = (int*) malloc(sim.nx * sim.nx * sizeof(int));
+	sim.next = (int*) calloc(n_polygons, sizeof(int));
+	sim.prev = (int*) calloc(n_polygons, sizeof(int));
+	sim.heapCapacity = 8 * n_polygons + 64;
+	sim.heap = (Event*) calloc(sim.heapCapacity, sizeof(Event));
+	for (int c = 0; c < sim.nx * sim.nx; ++c)
+		sim.cellHead[c] = -1;
+
+	double energy = 0.;
+	for (int i = 0; i < n_polygons; ++i) {
+		Particle *p = sim.particles + i;
+		const Polygon *pol = polArray + i;
+		float u[3];
+		rng_fill(rng, u, 3);
+		p->center = pol->center;
+		p->angle = atan2(pol->points[0].y - pol->center.y, pol->points[0].x - pol->center.x) - Pi / N_SIDES;
+		p->velocity = (Point) {2. * u[0] - 1., 2. * u[1] - 1.};
+		p->spin = (2. * u[2] - 1.) / sim.radius;
+		energy += norm2(&(p->velocity)) + sim.inertia * p->spin * p->spin;
+		insertInCell(&sim, i, cellOf(&sim, &(p->center)));
+	}
+	for (int i = 0; i < n_polygons; ++i)
+		predict(&sim, i, 0.);
+
+	double t = 0., lastSize = 1.;
+	for (int events = 0; events < iterationNumber && sim.heapLength > 0 && !timeIsUp(engine, events); ) {
+		const Event e = pop(&sim);
+		Particle *p = sim.particles + e.i;
+		if (e.scheduled != p->scheduled)
+			continue; // superseded
+		t = e.time;
+		advance(p, t);
+		if (e.other == CHECK_EVENT || (e.other >= 0 && sim.particles[e.other].version != e.version)) {
+			predict(&sim, e.i, t); // unfinished prediction, or the partner changed course
+			continue;
+		}
+
+		if (e.other == CELL_EVENT)
+			changeCell(&sim, e.i);
+		else if (e.other == WALL_EVENT) {
+			Contact c;
+			wallContact(&sim, p, t, &c);
+			collide(&sim, NULL, p, &c, t);
+			++p->version;
+		}
+		else if (e.other >= 0) {
+			Particle *q = sim.particles + e.other;
+			advance(q, t);
+			Contact c;
+			pairContact(&sim, p, q, t, &c);
+			collide(&sim, p, q, &c, t);
+			++p->version;
+			++q->version;
+			predict(&sim, e.other, t);
+		}
+		predict(&sim, e.i, t);
+
+		if (++events % (COMPRESS_PERIOD * n_polygons) == 0) {
+			if (sizeAt(t) - lastSize < COMPRESS_JAM_TOL * sizeAt(t))
+				break; // jammed
+			lastSize = sizeAt(t);
+			thermostat(&sim, t, energy);
+		}
+	}
+
+	// Polygons of size s in a container of side L are unit polygons in a container of side L / s:
+	const double size = sizeAt(t);
+	BufferPool *pool = enginePool(engine, n_polygons);
+	Polygon *candidate = acquireBuffer(pool);
+	for (int i = 0; i < n_polygons; ++i) {
+		Particle *p = sim.particles + i;
+		advance(p, t);
+		candidate[i] = createPolygon(p->center.x / size, p->center.y / size);
+		rotation(candidate + i, p->angle);
+	}
+	bool improved = false;
+	double newSide = 0, error = 0;
+	findErrorRatio(candidate, n_polygons, &newSide, &error);
+	if (error < sol->error && (checkConfiguration(candidate, n_polygons) || repairOverlaps(candidate, n_polygons, REPAIR_ROUNDS))) {
+		findErrorRatio(candidate, n_polygons, &newSide, &error);
+		if (error < sol->error) {
+			memcpy(polArray, candidate, n_polygons * sizeof(Polygon));
+			sol->bigSquareSide = newSide;
+			sol->error = error;
+			reportImprovement(engine, sol, iterationNumber, error);
+			improved = true;
+		}
+	}
+	releaseBuffer(pool, candidate);
+	free(sim.particles);
+	free(sim.cellHead);
+	free(sim.next);
+	free(sim.prev);
+	free(sim.heap);
+	return improved;
+}
@@ -0,0 +1,10 @@
+#ifndef COMPRESS_H
+#define COMPRESS_H
+
+#include <stdbool.h>
+#include "polygons.h"
+#include "engine.h"
+
+bool optimize_compress(Engine *engine, Solution *sol, int iterationNumber);
+
+#endif
@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "critical.h"
+
+CriticalSet* createCriticalSet(const Polygon *polArray, int n_polygons, double tolerance)
+{
+	CriticalSet *cs = (CriticalSet*) calloc(1, sizeof(CriticalSet));
+	cs->n_polygons = n_polygons;
+	cs->level = (int*) calloc(n_polygons, sizeof(int));
+	cs->members = (int*) calloc(n_polygons, sizeof(int));
+	cs->tolerance = tolerance;
+	for (int k = 0; k < CRITICAL_CLASSES; ++k)
+		cs->weights[k] = 1.;
+	criticalUpdate(cs, polArray);
+	return cs;
+}
+
+void freeCriticalSet(CriticalSet *cs)
+{
+	if (!cs)
+		return;
+	free(cs->level);
+	free(cs->members);
+	free(cs);
+}
+
+// True if a vertex of 'pol' is within the tolerance of a side of the last computed box.
+bool onBoundary(const CriticalSet *cs, const Polygon *pol)
+{
+	const Box b = findBoundary(pol, 1);
+	return b.xmin - cs->box.xmin <= cs->tolerance || cs->box.xmax - b.xmax <= cs->tolerance
+		|| b.ymin - cs->box.ymin <= cs->tolerance || cs->box.ymax - b.ymax <= cs->tolerance;
+}
+
+// Breadth first from the polygons on the box sides, through contacts, up to CRITICAL_DEPTH.
+// Contacts are approximated by circumscribed circles within the tolerance of each other.
+void criticalUpdate(CriticalSet *cs, const Polygon *polArray)
+{
+	const int n_polygons = cs->n_polygons, last = CRITICAL_CLASSES - 1;
+	const double reach = sqrt(getDiam2()) + cs->tolerance;
+	cs->box = findBoundary(polArray, n_polygons);
+
+	int n_queued = 0;
+	for (int i = 0; i < n_polygons; ++i) {
+		cs->level[i] = last;
+		if (onBoundary(cs, polArray + i)) {
+			cs->level[i] = 0;
+			cs->members[n_queued++] = i;
+		}
+	}
+	// 'members' is the queue, filled level by level:
+	cs->start[0] = 0;
+	for (int k = 1, head = 0; k < last; ++k) {
+		cs->start[k] = n_queued;
+		for (; head < cs->start[k]; ++head) {
+			const Polygon *pol = polArray + cs->members[head];
+			for (int j = 0; j < n_polygons; ++j) {
+				if (cs->level[j] == last && distance2(&(pol->center), &(polArray[j].center)) < reach * reach) {
+					cs->level[j] = k;
+					cs->members[n_queued++] = j;
+				}
+			}
+		}
+	}
+	cs->start[last] = n_queued;
+	for (int i = 0; i < n_polygons; ++i) {
+		if (cs->level[i] == last)
+			cs->members[n_queued++] = i;
+	}
+	cs->start[last + 1] = n_queued;
+}
+
+// Roulette over the non-empty classes, then uniform within the class.
+int criticalPick(const CriticalSet *cs, rng_type *rng, int *level)
+{
+	double total = 0.;
+	for (int k = 0; k < CRITICAL_CLASSES; ++k) {
+		if (cs->start[k+1] > cs->start[k])
+			total += cs->weights[k];
+	}
+	double u = total * rng_real(rng);
+	int k = 0;
+	for (; k < CRITICAL_CLASSES - 1; ++k) {
+		if (cs->start[k+1] == cs->start[k])
+			continue;
+		if (u < cs->weights[k])
+			break;
+		u -= cs->weights[k];
+	}
+	while (cs->start[k+1] == cs->start[k]) // rounding, or empty last class
+		--k;
+	*level = k;
+	const int size = cs->start[k+1] - cs->start[k];
+	return cs->members[cs->start[k] + (int) (rng_int(rng) % size)];
+}
+
+// Exponential moving average of the rewards of each class, kept above a floor
+// so that no class is starved.
+void criticalReward(CriticalSet *cs, int level, double reward)
+{
+	const double w = (1. - CRITICAL_RATE) * cs->weights[level] + CRITICAL_RATE * reward;
+	cs->weights[level] = fmax(w, CRITICAL_MIN_WEIGHT);
+}
+
+// Moves of polygons picked from the critical set, see searchMoves().
+bool optimize_critical(Engine *engine, Solution *sol, int iterationNumber)
+{
+	return searchMoves(engine, sol, iterationNumber, true, "optimize_critical");
+}
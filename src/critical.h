@@ -0,0 +1,32 @@
+#ifndef CRITICAL_H
+#define CRITICAL_H
+
+#include <stdbool.h>
+#include "polygons.h"
+#include "engine.h"
+
+#define CRITICAL_CLASSES (CRITICAL_DEPTH + 2)
+
+// Polygons ranked by how directly they define the bounding box: level 0 for those with a vertex
+// on one of its sides, level k for those in contact with a level k-1 one, the rest being in the
+// last class. Each class has an adaptive weight, its probability to be picked for the next move.
+typedef struct
+{
+	int n_polygons;
+	int *level;
+	int *members; // sorted by level
+	int start[CRITICAL_CLASSES + 1]; // members of level k are at start[k], ..., start[k+1]-1
+	double weights[CRITICAL_CLASSES];
+	Box box;
+	double tolerance; // distance at which a polygon touches the box or another one
+} CriticalSet;
+
+CriticalSet* createCriticalSet(const Polygon *polArray, int n_polygons, double tolerance);
+void freeCriticalSet(CriticalSet *cs);
+void criticalUpdate(CriticalSet *cs, const Polygon *polArray);
+bool onBoundary(const CriticalSet *cs, const Polygon *pol);
+int criticalPick(const CriticalSet *cs, rng_type *rng, int *level);
+void criticalReward(CriticalSet *cs, int level, double reward);
+bool optimize_critical(Engine *engine, Solution *sol, int iterationNumber);
+
+#endif
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include "decompose.h"
+#include "overlap.h"
+#include "sap.h"
+#include "search.h"
+
+// Polygons bucketed by the cell containing their center. Cells on the border extend to
+// infinity, so that every polygon belongs to one.
+typedef struct
+{
+	Point origin;
+	double side;
+	int nx, ny;
+	int *start; // nx * ny + 1 offsets in 'items'
+	int *items;
+} Grid;
+
+// Frozen polygons of the neighbouring tiles, close enough to touch the tile ones.
+typedef struct
+{
+	int *halo;
+	int n_halo;
+} Tile;
+
+typedef struct
+{
+	const Engine *engine;
+	Polygon *polArray;
+	const Grid *grid;
+	const Tile *tiles;
+	const Box *container;
+	int color;
+	int stepsPerPolygon;
+	uint64_t seed;
+	int next; // next tile to be claimed. Atomic.
+} Phase;
+
+static int cellCoord(double x, double origin, double side, int n)
+{
+	const double k = floor((x - origin) / side);
+	return k < 0. ? 0 : k >= n ? n-1 : (int) k;
+}
+
+static int cellOf(const Grid *grid, const Point *p)
+{
+	return cellCoord(p->y, grid->origin.y, grid->side, grid->ny) * grid->nx
+		+ cellCoord(p->x, grid->origin.x, grid->side, grid->nx);
+}
+
+// Counting sort of the polygons by cell.
+static void buildGrid(Grid *grid, const Polygon *polArray, int n_polygons, Point origin, double side, int nx, int ny)
+{
+	*grid = (Grid) {origin, side, nx, ny, NULL, NULL};
+	const int cells = nx * ny;
+	grid->start = (int*) calloc(cells + 1, sizeof(int));
+	grid->items = (int*) calloc(n_polygons, sizeof(int));
+	int *cellIndex = (int*) calloc(n_polygons, sizeof(int));
+	for (int i = 0; i < n_polygons; ++i) {
+		cellIndex[i] = cellOf(grid, &(polArray[i].center));
+		++grid->start[cellIndex[i] + 1];
+	}
+	for (int c = 0; c < cells; ++c)
+		grid->start[c+1] += grid->start[c];
+	int *fill = (int*) calloc(cells, sizeof(int));
+	for (int i = 0; i < n_polygons; ++i)
+		grid->items[grid->start[cellIndex[i]] + fill[cellIndex[i]]++] = i;
+	free(fill);
+	free(cellIndex);
+}
+
+static void freeGrid(Grid *grid)
+{
+	free(grid->start);
+	free(grid->items);
+}
+
+static Box cellBox(const Grid *grid, int cx, int cy)
+{
+	return (Box) {
+		cx == 0 ? -INFINITY : grid->origin.x + cx * grid->side,
+		cx == grid->nx-1 ? INFINITY : grid->origin.x + (cx+1) * grid->side,
+		cy == 0 ? -INFINITY : grid->origin.y + cy * grid->side,
+		cy == grid->ny-1 ? INFINITY : grid->origin.y + (cy+1) * grid->side};
+}
+
+static double boxDistance2(const Box *box, const Point *p)
+{
+	const double dx = fmax(fmax(box->xmin - p->x, p->x - box->xmax), 0.);
+	const double dy = fmax(fmax(box->ymin - p->y, p->y - box->ymax), 0.);
+	return dx * dx + dy * dy;
+}
+
+// Tiles must be at least 'reach' wide, for halos to only come from adjacent tiles.
+static Tile* buildTiles(const Grid *grid, const Polygon *polArray, double reach)
+{
+	const int cells = grid->nx * grid->ny;
+	Tile *tiles = (Tile*) calloc(cells, sizeof(Tile));
+	// Two passes: counting, then filling the halos.
+	for (int pass = 0; pass < 2; ++pass) {
+		for (int c = 0; c < cells; ++c) {
+			const int cx = c % grid->nx, cy = c / grid->nx;
+			for (int a = grid->start[c]; a < grid->start[c+1]; ++a) {
+				const int i = grid->items[a];
+				for (int dy = -1; dy <= 1; ++dy) {
+					for (int dx = -1; dx <= 1; ++dx) {
+						const int nx = cx + dx, ny = cy + dy;
+						if ((!dx && !dy) || nx < 0 || ny < 0 || nx >= grid->nx || ny >= grid->ny)
+							continue;
+						const Box box = cellBox(grid, nx, ny);
+						if (boxDistance2(&box, &(polArray[i].center)) >= reach * reach)
+							continue;
+						Tile *tile = tiles + ny * grid->nx + nx;
+						if (pass)
+							tile->halo[tile->n_halo] = i;
+						++tile->n_halo;
+					}
+				}
+			}
+		}
+		if (pass == 0) {
+			for (int c = 0; c < cells; ++c) {
+				tiles[c].halo = (int*) calloc(tiles[c].n_halo + 1, sizeof(int));
+				tiles[c].n_halo = 0;
+			}
+		}
+	}
+	return tiles;
+}
+
+static void freeTiles(Tile *tiles, int cells)
+{
+	for (int c = 0; c < cells; ++c)
+		free(tiles[c].halo);
+	free(tiles);
+}
+
+// Penalty of polygon 'k' against the container and the other polygons of the tile, halo included.
+// 'shared' is set to the part due to the other mobile polygons.
+static double localPenalty(const Phase *phase, const Tile *tile, const int *mobile, int n_mobile, int k, double *shared)
+{
+	const Polygon *polArray = phase->polArray, *pol = polArray + k;
+	*shared = 0.;
+	for (int a = 0; a < n_mobile; ++a) {
+		if (mobile[a] != k)
+			*shared += pairArea(pol, polArray + mobile[a]);
+	}
+	double penalty = protrusionArea(pol, phase->container) + *shared;
+	for (int a = 0; a < tile->n_halo; ++a)
+		penalty += pairArea(pol, polArray + tile->halo[a]);
+	return penalty;
+}
+
+// Same moves as optimize_feasibility(), restricted to the tile polygons, whose centers may not leave it.
+static void relaxTile(const Phase *phase, int t)
+{
+	const int *mobile = phase->grid->items + phase->grid->start[t];
+	const int n_mobile = phase->grid->start[t+1] - phase->grid->start[t];
+	const Tile *tile = phase->tiles + t;
+	if (!n_mobile)
+		return;
+
+	// Sum of the local penalties, pairs of mobile polygons being counted twice:
+	double penalty = 0., shared = 0.;
+	for (int a = 0; a < n_mobile; ++a)
+		penalty += localPenalty(phase, tile, mobile, n_mobile, mobile[a], &shared);
+
+	rng_type rng;
+	rng_init(&rng, phase->seed, t);
+	const int steps = phase->stepsPerPolygon * n_mobile;
+	for (int step = 0; step < steps && penalty > phase->engine->params.epsilon; ++step) {
+		const int k = mobile[rng_int(&rng) % n_mobile];
+		Polygon *pol = phase->polArray + k;
+		const Polygon saved = *pol;
+		double sharedBefore = 0., sharedAfter = 0.;
+		const double before = localPenalty(phase, tile, mobile, n_mobile, k, &sharedBefore);
+		signedMutation(&rng, &(phase->engine->params), pol);
+		if (cellOf(phase->grid, &(pol->center)) != t) {
+			*pol = saved;
+			continue;
+		}
+		const double after = localPenalty(phase, tile, mobile, n_mobile, k, &sharedAfter);
+		if (after <= before)
+			penalty += after - before + sharedAfter - sharedBefore;
+		else // backtracking
+			*pol = saved;
+	}
+}
+
+static void* phaseWorker(void *arg)
+{
+	Phase *phase = (Phase*) arg;
+	const int cells = phase->grid->nx * phase->grid->ny;
+	int t;
+	while ((t = __atomic_fetch_add(&phase->next, 1, __ATOMIC_RELAXED)) < cells) {
+		const int tx = t % phase->grid->nx, ty = t / phase->grid->nx;
+		if ((tx & 1) + 2 * (ty & 1) == phase->color)
+			relaxTile(phase, t);
+	}
+	return NULL;
+}
+
+// Tiles of a same color are not adjacent, thus never share a halo polygon and can be relaxed in parallel.
+// Each tile has its own rng stream, hence results do not depend on the number of threads.
+static void runPhase(Phase *phase)
+{
+	pthread_t threads[DECOMPOSE_THREADS];
+	int n_threads = 0;
+	for (; n_threads < DECOMPOSE_THREADS - 1; ++n_threads) {
+		if (pthread_create(threads + n_threads, NULL, phaseWorker, phase))
+			break; // the remaining work is done by the threads already running
+	}
+	phaseWorker(phase);
+	for (int k = 0; k < n_threads; ++k)
+		pthread_join(threads[k], NULL);
+}
+
+static double pairPenalty(const Polygon *pol1, const Polygon *pol2, bool *valid)
+{
+	if (*valid && intersects(pol1, pol2))
+		*valid = false;
+	return pairArea(pol1, pol2);
+}
+
+#ifndef SWEEP_AND_PRUNE
+// Total intersection area plus protrusions, pairs being found through cells one polygon
+// diameter wide. 'valid' is set as in checkConfiguration(), in linear time as well.
+static double gridPenalty(const Polygon *polArray, int n_polygons, const Box *container, bool *valid)
+{
+	const double diam = sqrt(getDiam2());
+	const Box b = findBoundary(polArray, n_polygons);
+	Grid grid;
+	buildGrid(&grid, polArray, n_polygons, (Point) {b.xmin, b.ymin}, diam,
+		(int) ((b.xmax - b.xmin) / diam) + 1, (int) ((b.ymax - b.ymin) / diam) + 1);
+
+	double penalty = 0.;
+	*valid = true;
+	for (int c = 0; c < grid.nx * grid.ny; ++c) {
+		const int cx = c % grid.nx, cy = c / grid.nx;
+		for (int a = grid.start[c]; a < grid.start[c+1]; ++a) {
+			const int i = grid.items[a];
+			penalty += protrusionArea(polArray + i, container);
+			for (int dy = -1; dy <= 1; ++dy) {
+				for (int dx = -1; dx <= 1; ++dx) {
+					const int nx = cx + dx, ny = cy + dy;
+					if (nx < 0 || ny < 0 || nx >= grid.nx || ny >= grid.ny)
+						continue;
+					const int d = ny * grid.nx + nx;
+					for (int e = grid.start[d]; e < grid.start[d+1]; ++e) {
+						const int j = grid.items[e];
+						if (j > i)
+							penalty += pairPenalty(polArray + i, polArray + j, valid);
+					}
+				}
+			}
+		}
+	}
+	freeGrid(&grid);
+	return penalty;
+}
+#else
+// Same as gridPenalty(), pairs being found by sweep and prune instead.
+static double sapPenalty(const Polygon *polArray, int n_polygons, const Box *container, bool *valid)
+{
+	SweepAndPrune *sap = createSweepAndPrune(polArray, n_polygons);
+	const int n_found = sapOverlaps(sap);
+	double penalty = 0.;
+	*valid = true;
+	for (int i = 0; i < n_polygons; ++i)
+		penalty += protrusionArea(polArray + i, container);
+	for (int k = 0; k < n_found; ++k)
+		penalty += pairPenalty(polArray + sap->found[2*k], polArray + sap->found[2*k+1], valid);
+	freeSweepAndPrune(sap);
+	return penalty;
+}
+#endif
+
+typedef struct
+{
+	Engine *engine;
+	int n_polygons;
+	int stepsPerPolygon;
+	double diam, tileSide;
+} TileTrial;
+
+// Sweeps of the tiles, until the penalty vanishes.
+static bool tileTrial(void *data, Polygon *polArray, const Box *container, int *iteration)
+{
+	TileTrial *t = (TileTrial*) data;
+	Engine *engine = t->engine;
+	rng_type *rng = &engine->rng;
+	const int n_polygons = t->n_polygons;
+	const double side = container->xmax - container->xmin, tileSide = t->tileSide;
+	double penalty = INFINITY;
+	bool valid = false;
+	for (int sweep = 0; sweep < TILE_SWEEPS && !deadlineReached(engine); ++sweep) {
+		const double shift = sweep % 2 ? tileSide / 2. : 0.;
+		const int count = (int) ceil((side + shift) / tileSide);
+		Grid grid;
+		buildGrid(&grid, polArray, n_polygons, (Point) {container->xmin - shift, container->ymin - shift},
+			tileSide, count, count);
+		Tile *tiles = buildTiles(&grid, polArray, t->diam);
+		const uint64_t high = rng_int(rng), seed = high << 32 | rng_int(rng);
+		for (int color = 0; color < 4; ++color) {
+			Phase phase = {engine, polArray, &grid, tiles, container, color, t->stepsPerPolygon, seed, 0};
+			runPhase(&phase);
+		}
+		freeTiles(tiles, count * count);
+		freeGrid(&grid);
+		*iteration += t->stepsPerPolygon * n_polygons;
+
+#ifdef SWEEP_AND_PRUNE
+		penalty = sapPenalty(polArray, n_polygons, container, &valid);
+#else
+		penalty = gridPenalty(polArray, n_polygons, container, &valid);
+#endif
+		if (penalty <= engine->params.epsilon && valid)
+			break;
+	}
+	return penalty <= engine->params.epsilon && valid;
+}
+
+// Decomposition strategy for large n. As in optimize_feasibility(), the container side L is found by
+// bisection, see bisectSide(), but for each L the penalty is minimized tile by tile: the container is cut
+// into square tiles of about TILE_POLYGONS polygons, each one moving its own polygons against a frozen halo
+// of its neighbours. Tiles are relaxed in 4 colored phases, tiles of a same color running in parallel. Every
+// other sweep, tiles are shifted by half a tile, for the polygons along the seams to be relaxed too.
+// Returns true if the solution has been improved.
+bool optimize_tiles(Engine *engine, Solution *sol, int iterationNumber)
+{
+	const int n_polygons = sol->n_polygons;
+	const double diam = sqrt(getDiam2());
+	int stepsPerPolygon = iterationNumber / (FEASIBILITY_ROUNDS * TILE_SWEEPS * n_polygons);
+	if (stepsPerPolygon < 1)
+		stepsPerPolygon = 1;
+	TileTrial trial = {engine, n_polygons, stepsPerPolygon, diam, fmax(2. * diam, sqrt(TILE_POLYGONS))};
+	return bisectSide(engine, sol, tileTrial, &trial);
+}
@@ -0,0 +1,10 @@
+#ifndef DECOMPOSE_H
+#define DECOMPOSE_H
+
+#include <stdbool.h>
+#include "polygons.h"
+#include "engine.h"
+
+bool optimize_tiles(Engine *engine, Solution *sol, int iterationNumber);
+
+#endif
@@ -1,14 +1,10 @@
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <math.h>
 #include "drawing.h"
 #include "settings.h"
 
-extern SDL_Window *window;
-extern SDL_Renderer *renderer;
-static SDL_Event event = {0};
-const SDL_Color Lime = {0, 255, 0, 255};
-const SDL_Color Yellow = {255, 255, 0, 255};
-
 Point projection(Point p, Point offset, double scale)
 {
 	return (Point) {offset.x + p.x * scale, offset.y + p.y * scale};
@@ -24,7 +20,13 @@ void computeProjection(Solution sol, Point *offset, double *scale)
 	offset->y = (WINDOW_HEIGHT - *scale * (box.ymin + box.ymax))/2.;
 }
 
-void drawPoint(const Point *point, const SDL_Color *color)
+#ifdef USE_SDL2
+
+// The window and renderer belong to the thread drawing in them, and are passed around.
+static const SDL_Color Lime = {0, 255, 0, 255};
+static const SDL_Color Yellow = {255, 255, 0, 255};
+
+void drawPoint(SDL_Renderer *renderer, const Point *point, const SDL_Color *color)
 {
 	if (!point) {
 		printf("Cannot draw a NULL Point.\n");
@@ -35,7 +37,7 @@ void drawPoint(const Point *point, const SDL_Color *color)
 	SDL_RenderFillRect(renderer, &rect);
 }
 
-void drawSegment(const Segment *segment, const SDL_Color *color)
+void drawSegment(SDL_Renderer *renderer, const Segment *segment, const SDL_Color *color)
 {
 	if (!segment)
 		return;
@@ -50,55 +52,238 @@ void drawSegment(const Segment *segment, const SDL_Color *color)
 	}
 }
 
-void drawPolygonalChain(const Point *points, int length, bool closed)
+void drawPolygonalChain(SDL_Renderer *renderer, const Point *points, int length, bool closed)
 {
 	for (int i = 0; i < length-!closed; ++i)
-		drawSegment(&(Segment) {points + i, points + (i+1) % length}, &Yellow);
+		drawSegment(renderer, &(Segment) {points + i, points + (i+1) % length}, &Yellow);
 	for (int i = 0; i < length; ++i)
-		drawPoint(points + i, &Lime);
+		drawPoint(renderer, points + i, &Lime);
+}
+
+void drawPolygon(SDL_Renderer *renderer, const Polygon *polygon)
+{
+	drawPolygonalChain(renderer, polygon->points, N_SIDES, true);
+}
+
+static bool quitEvent(const SDL_Event *event)
+{
+	return event->type == SDL_QUIT ||
+		(event->type == SDL_KEYDOWN && event->key.keysym.sym == QUIT_KEY_1) ||
+		(event->type == SDL_KEYDOWN && event->key.keysym.sym == QUIT_KEY_2);
+}
+
+/////////////////////////////////////////////
+// Batched drawing:
+/////////////////////////////////////////////
+
+// All segments are drawn in a single SDL_RenderGeometry() call, as thin quads,
+// and all points in a single SDL_RenderFillRects() call.
+DrawBatch* createDrawBatch(SDL_Renderer *renderer, int n_polygons)
+{
+	DrawBatch *batch = (DrawBatch*) calloc(1, sizeof(DrawBatch));
+	batch->renderer = renderer;
+	batch->capacity = n_polygons;
+	batch->rects = (SDL_Rect*) calloc(n_polygons * N_SIDES, sizeof(SDL_Rect));
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	batch->vertices = (SDL_Vertex*) calloc(4 * n_polygons * N_SIDES, sizeof(SDL_Vertex));
+	batch->indices = (int*) calloc(6 * n_polygons * N_SIDES, sizeof(int));
+	for (int k = 0; k < n_polygons * N_SIDES; ++k) {
+		const int quad[6] = {0, 1, 2, 2, 1, 3};
+		for (int l = 0; l < 6; ++l)
+			batch->indices[6 * k + l] = 4 * k + quad[l];
+	}
+#else
+	batch->chain = (SDL_Point*) calloc(N_SIDES + 1, sizeof(SDL_Point));
+#endif
+	return batch;
+}
+
+void freeDrawBatch(DrawBatch *batch)
+{
+	if (!batch)
+		return;
+	free(batch->rects);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	free(batch->vertices);
+	free(batch->indices);
+#else
+	free(batch->chain);
+#endif
+	free(batch);
 }
 
-void drawPolygon(const Polygon *polygon)
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+static void setQuad(SDL_Vertex *quad, const Point *A, const Point *B, const SDL_Color *color)
 {
-	drawPolygonalChain(polygon->points, N_SIDES, true);
+	const double len = distance(A, B);
+	const double nx = len < EPSILON ? 0. : -(B->y - A->y) / (2. * len); // half pixel wide
+	const double ny = len < EPSILON ? 0. :  (B->x - A->x) / (2. * len);
+	quad[0].position = (SDL_FPoint) {A->x + nx, A->y + ny};
+	quad[1].position = (SDL_FPoint) {A->x - nx, A->y - ny};
+	quad[2].position = (SDL_FPoint) {B->x + nx, B->y + ny};
+	quad[3].position = (SDL_FPoint) {B->x - nx, B->y - ny};
+	for (int l = 0; l < 4; ++l)
+		quad[l].color = *color;
+}
+#endif
+
+static void drawPolygonsBatch(DrawBatch *batch, Solution sol)
+{
+	Point offset = {0}; double scale = 0.;
+	computeProjection(sol, &offset, &scale);
+	const int n_polygons = sol.n_polygons < batch->capacity ? sol.n_polygons : batch->capacity;
+
+	SDLA_SetDrawColor(Yellow.r, Yellow.g, Yellow.b);
+	for (int i = 0; i < n_polygons; ++i) {
+		Point projected[N_SIDES];
+		for (int j = 0; j < N_SIDES; ++j) {
+			projected[j] = projection(sol.polArray[i].points[j], offset, scale);
+			batch->rects[i * N_SIDES + j] = (SDL_Rect) {projected[j].x - POINT_SIZE / 2,
+				projected[j].y - POINT_SIZE / 2, POINT_SIZE, POINT_SIZE};
+		}
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		for (int j = 0; j < N_SIDES; ++j)
+			setQuad(batch->vertices + 4 * (i * N_SIDES + j), projected + j, projected + (j+1) % N_SIDES, &Yellow);
+#else
+		for (int j = 0; j <= N_SIDES; ++j)
+			batch->chain[j] = (SDL_Point) {projected[j % N_SIDES].x, projected[j % N_SIDES].y};
+		SDL_RenderDrawLines(batch->renderer, batch->chain, N_SIDES + 1);
+#endif
+	}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	const int segments = n_polygons * N_SIDES;
+	SDL_RenderGeometry(batch->renderer, NULL, batch->vertices, 4 * segments, batch->indices, 6 * segments);
+#endif
+
+	SDLA_SetDrawColor(Lime.r, Lime.g, Lime.b);
+	SDL_RenderFillRects(batch->renderer, batch->rects, n_polygons * N_SIDES);
+}
+
+// Returns NULL if the font is missing, instead of exiting like SDLA_CachingFontAll().
+static CachedFont* loadHudFont(void)
+{
+	TTF_Font *font = TTF_OpenFont(FONT_NAME, FONT_SIZE);
+	if (!font)
+		return NULL;
+	TTF_CloseFont(font);
+	return SDLA_CachingFontAll(FONT_NAME, &Yellow, FONT_SIZE);
+}
+
+// Draws the given solution and its details. 'status' may be NULL.
+static void drawFrame(DrawBatch *batch, Solution sol, const CachedFont *font, const char *status)
+{
+	SDLA_ClearWindow(NULL);
+	drawPolygonsBatch(batch, sol);
+
+	if (font) {
+		char bufferStr[100] = {0};
+		sprintf(bufferStr, "Polygons sides: %d and number: %d", N_SIDES, sol.n_polygons);
+		SDLA_DrawCachedFont(font, 50, 50, bufferStr);
+		sprintf(bufferStr, "Error ratio: %.4f", sol.error);
+		SDLA_DrawCachedFont(font, 50, 100, bufferStr);
+		sprintf(bufferStr, "Big square size: %.4f", sol.bigSquareSide);
+		SDLA_DrawCachedFont(font, 50, 150, bufferStr);
+		if (status)
+			SDLA_DrawCachedFont(font, 50, 200, status);
+	}
+
+	SDL_RenderPresent(batch->renderer);
 }
 
 void animation(Solution sol)
 {
+	SDL_Window *window = NULL;
+	SDL_Renderer *renderer = NULL;
+	SDL_Event event = {0};
 	SDLA_Init(&window, &renderer, "Polygons packing", WINDOW_WIDTH, WINDOW_HEIGHT, 0, SDLA_BLENDED);
-	TTF_Font *font = TTF_OpenFont(FONT_NAME, FONT_SIZE);
+	CachedFont *font = loadHudFont();
+	DrawBatch *batch = createDrawBatch(renderer, sol.n_polygons);
 	while (1) {
-		SDLA_ClearWindow(NULL);
+		drawFrame(batch, sol, font, NULL);
+		SDL_WaitEvent(&event);
+		if (quitEvent(&event))
+			break;
+	}
+	freeDrawBatch(batch);
+	if (font)
+		SDLA_FreeCachedFont(font);
+	SDLA_Quit();
+}
 
-		// 'sol' could be updated here...
+/////////////////////////////////////////////
+// Live animation:
+/////////////////////////////////////////////
 
-		Point offset = {0}; double scale = 0.;
-		computeProjection(sol, &offset, &scale);
+// All SDL calls are made from the render thread. The search thread only publishes
+// snapshots and sets 'searchDone', it never waits on the render thread before that.
+static void* renderLoop(void *arg)
+{
+	LiveAnimation *live = (LiveAnimation*) arg;
+	SDL_Window *window = NULL;
+	SDL_Renderer *renderer = NULL;
+	SDL_Event event = {0};
+	SDLA_Init(&window, &renderer, "Polygons packing", WINDOW_WIDTH, WINDOW_HEIGHT, 0, SDLA_BLENDED);
+	CachedFont *font = loadHudFont();
+	DrawBatch *batch = createDrawBatch(renderer, live->buffer->slots[0].n_polygons);
+	const Uint32 frameDuration = 1000 / LIVE_FPS; // in ms
 
-		for (int i = 0; i < sol.n_polygons; ++i) {
-			const Point *points = sol.polArray[i].points;
-			Polygon projectedPolygon = {0}; // 'center' left to (0, 0)
-			for (int j = 0; j < N_SIDES; ++j)
-				projectedPolygon.points[j] = projection(points[j], offset, scale);
-			drawPolygon(&projectedPolygon);
+	bool running = true, drawn = false;
+	while (running) {
+		const Uint32 frameStart = SDL_GetTicks();
+		const bool searchDone = __atomic_load_n(&live->searchDone, __ATOMIC_ACQUIRE);
+
+		bool fresh = false;
+		const Snapshot *snap = latestSnapshot(live->buffer, &fresh);
+		if (snap->iteration >= 0 && (fresh || !drawn || searchDone)) {
+			const Solution sol = {snap->polArray, snap->n_polygons, snap->bigSquareSide, snap->error};
+			char status[100] = {0};
+			if (searchDone)
+				sprintf(status, "Search done");
+			else
+				sprintf(status, "Searching... iteration: %d", snap->iteration);
+			drawFrame(batch, sol, font, status);
+			drawn = true;
 		}
-		if (font) {
-			char bufferStr[100] = {0};
-			sprintf(bufferStr, "Polygons sides: %d and number: %d", N_SIDES, sol.n_polygons);
-			SDLA_SlowDrawText(font, &Yellow, 50, 50, bufferStr);
-			sprintf(bufferStr, "Error ratio: %.4f", sol.error);
-			SDLA_SlowDrawText(font, &Yellow, 50, 100, bufferStr);
-			sprintf(bufferStr, "Big square size: %.4f", sol.bigSquareSide);
-			SDLA_SlowDrawText(font, &Yellow, 50, 150, bufferStr);
+
+		if (searchDone) { // nothing left to update, waiting for the user.
+			SDL_WaitEventTimeout(&event, frameDuration);
+			running = !quitEvent(&event);
 		}
+		while (running && SDL_PollEvent(&event))
+			running = !quitEvent(&event);
 
-		SDL_RenderPresent(renderer);
-		SDL_WaitEvent(&event);
-		if (event.type == SDL_QUIT ||
-			(event.type == SDL_KEYDOWN && event.key.keysym.sym == QUIT_KEY_1) ||
-			(event.type == SDL_KEYDOWN && event.key.keysym.sym == QUIT_KEY_2))
-			break;
+		const Uint32 elapsed = SDL_GetTicks() - frameStart;
+		if (running && elapsed < frameDuration)
+			SDL_Delay(frameDuration - elapsed);
 	}
-	TTF_CloseFont(font);
+	freeDrawBatch(batch);
+	if (font)
+		SDLA_FreeCachedFont(font);
 	SDLA_Quit();
+	return NULL;
+}
+
+LiveAnimation* startLiveAnimation(SnapshotBuffer *buffer)
+{
+	LiveAnimation *live = (LiveAnimation*) calloc(1, sizeof(LiveAnimation));
+	live->buffer = buffer;
+	if (pthread_create(&live->thread, NULL, renderLoop, live)) {
+		printf("Cannot start the render thread.\n");
+		free(live);
+		return NULL;
+	}
+	return live;
 }
+
+// To be called once the search is over. Returns when the window gets closed.
+void waitLiveAnimation(LiveAnimation *live)
+{
+	if (!live)
+		return;
+	__atomic_store_n(&live->searchDone, 1, __ATOMIC_RELEASE);
+	pthread_join(live->thread, NULL);
+	free(live);
+}
+
+#endif
@@ -1,16 +1,47 @@
 #ifndef DRAWING_H
 #define DRAWING_H
 
-#include "SDLA.h"
 #include "polygons.h"
 #include "geom_tools.h"
 
 Point projection(Point p, Point offset, double scale);
 void computeProjection(Solution sol, Point *offset, double *scale);
-void drawPoint(const Point *point, const SDL_Color *color);
-void drawSegment(const Segment *segment, const SDL_Color *color);
-void drawPolygonalChain(const Point *points, int length, bool closed);
-void drawPolygon(const Polygon *polygon);
+
+#ifdef USE_SDL2
+#include <pthread.h>
+#include "SDLA.h"
+#include "snapshot.h"
+
+typedef struct
+{
+	SnapshotBuffer *buffer;
+	int searchDone; // atomic
+	pthread_t thread;
+} LiveAnimation;
+
+// Preallocated buffers, for drawing all polygons with a few SDL calls per frame:
+typedef struct
+{
+	SDL_Renderer *renderer;
+	int capacity; // polygons
+	SDL_Rect *rects;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	SDL_Vertex *vertices;
+	int *indices;
+#else
+	SDL_Point *chain; // no SDL_RenderGeometry() before SDL v2.0.18
+#endif
+} DrawBatch;
+
+void drawPoint(SDL_Renderer *renderer, const Point *point, const SDL_Color *color);
+void drawSegment(SDL_Renderer *renderer, const Segment *segment, const SDL_Color *color);
+void drawPolygonalChain(SDL_Renderer *renderer, const Point *points, int length, bool closed);
+void drawPolygon(SDL_Renderer *renderer, const Polygon *polygon);
+DrawBatch* createDrawBatch(SDL_Renderer *renderer, int n_polygons);
+void freeDrawBatch(DrawBatch *batch);
 void animation(Solution sol);
+LiveAnimation* startLiveAnimation(SnapshotBuffer *buffer);
+void waitLiveAnimation(LiveAnimation *live);
+#endif
 
 #endif
@@ -0,0 +1,126 @@
+#define _POSIX_C_SOURCE 200112L // for posix_memalign()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "engine.h"
+
+Parameters defaultParameters(void)
+{
+	return (Parameters) {STEP_SIZE, ROTATION_PROBA, NEIGHBOURHOOD, EPSILON, TEMPERATURE, COOLING, OPTIMIZER};
+}
+
+// Every STEP_ADAPT_PERIOD trials, the step size and the rotation probability (which also bounds the
+// rotation angles) are multiplied by STEP_ADAPT_FACTOR if any trial of the window succeeded, and divided
+// by it otherwise. Once the step size falls below STEP_MIN, both are reset to 'initial'. This is no 1/5th
+// success rule: improvements being rare, the step mostly shrinks from 'initial' and restarts from it.
+// To be called after each trial, on a copy of the engine parameters.
+void growOnSuccess(Parameters *params, const Parameters *initial, SuccessWindow *window, bool success)
+{
+	if (STEP_ADAPT_PERIOD <= 0)
+		return;
+	window->successes += success;
+	if (++window->trials < STEP_ADAPT_PERIOD)
+		return;
+	const double factor = window->successes > 0 ? STEP_ADAPT_FACTOR : 1. / STEP_ADAPT_FACTOR;
+	params->stepSize = fmin(params->stepSize * factor, STEP_MAX);
+	params->rotationProba = fmin(fmax(params->rotationProba * factor, ROTATION_PROBA_MIN), ROTATION_PROBA_MAX);
+	if (params->stepSize < STEP_MIN) {
+		params->stepSize = initial->stepSize;
+		params->rotationProba = initial->rotationProba;
+	}
+	*window = (SuccessWindow) {0, 0};
+}
+
+// Default parameters, progress printed on stdout, no snapshots. Different streams of
+// the same seed give independent and reproducible searches.
+void initEngine(Engine *engine, uint64_t seed, uint64_t stream)
+{
+	memset(engine, 0, sizeof(Engine));
+	engine->params = defaultParameters();
+	initMoveLibrary(&engine->moves);
+	rng_init(&engine->rng, seed, stream);
+	engine->onImprovement = printImprovement;
+}
+
+// For engines living on the heap, aligned on cache lines.
+Engine* createEngine(uint64_t seed, uint64_t stream)
+{
+	void *memory = NULL;
+	if (posix_memalign(&memory, CACHE_LINE, sizeof(Engine))) {
+		printf("Cannot allocate an engine.\n");
+		exit(1);
+	}
+	Engine *engine = (Engine*) memory;
+	initEngine(engine, seed, stream);
+	return engine;
+}
+
+// Frees what the engine owns, but not the engine itself.
+void clearEngine(Engine *engine)
+{
+	freeBufferPool(engine->pool);
+	engine->pool = NULL;
+	clearMoveLibrary(&engine->moves);
+}
+
+void freeEngine(Engine *engine)
+{
+	clearEngine(engine);
+	free(engine);
+}
+
+// The pool is recreated if the number of polygons changes while no buffer is in use.
+BufferPool* enginePool(Engine *engine, int n_polygons)
+{
+	if (engine->pool && engine->pool->n_polygons != n_polygons) {
+		if (engine->pool->n_acquired) {
+			printf("Cannot use a pool of %d polygons buffers with %d polygons.\n", engine->pool->n_polygons, n_polygons);
+			exit(1);
+		}
+		clearEngine(engine);
+	}
+	if (!engine->pool)
+		engine->pool = createBufferPool(n_polygons);
+	return engine->pool;
+}
+
+void printImprovement(void *data, const Solution *sol, int iteration, double score)
+{
+	(void) data;
+	(void) sol;
+	printf("Improvement at iteration %d: %.4f\n", iteration, score);
+}
+
+// 'sol' must be up to date.
+void reportImprovement(Engine *engine, const Solution *sol, int iteration, double score)
+{
+	if (engine->onImprovement)
+		engine->onImprovement(engine->sinkData, sol, iteration, score);
+	if (engine->snapshots)
+		publishSnapshot(engine->snapshots, sol, iteration);
+}
+
+// Seconds since an arbitrary point, not affected by changes of the system time.
+double monotonicTime(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + 1.e-9 * now.tv_nsec;
+}
+
+// The budget starts now. A non-positive budget means no deadline.
+void setTimeBudget(Engine *engine, double seconds)
+{
+	engine->deadline = seconds > 0. ? monotonicTime() + seconds : 0.;
+	engine->expired = false;
+}
+
+bool deadlineReached(Engine *engine)
+{
+	if (!engine->expired && engine->deadline > 0. && monotonicTime() >= engine->deadline)
+		engine->expired = true;
+	return engine->expired;
+}
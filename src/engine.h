@@ -0,0 +1,54 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "settings.h"
+#include "params.h"
+#include "polygons.h"
+#include "snapshot.h"
+#include "pool.h"
+#include "moves.h"
+
+// Called on each improvement. 'score' is what the engine optimizes.
+typedef void (*ImprovementSink)(void *data, const Solution *sol, int iteration, double score);
+
+// Everything a search needs besides the solution itself. Engines share no mutable state,
+// thus any number of threads can each run their own. Engines are aligned on cache lines,
+// so that two of them never share one.
+typedef struct Engine
+{
+	Parameters params;
+	rng_type rng;
+	ImprovementSink onImprovement; // may be NULL
+	void *sinkData;
+	SnapshotBuffer *snapshots;     // may be NULL
+	BufferPool *pool;              // configuration buffers, created on first use
+	MoveLibrary moves;             // move operators and their yields, learned across searches
+	double deadline;               // monotonic time in seconds, 0 for none
+	bool expired;
+} __attribute__((aligned(CACHE_LINE))) Engine;
+
+Parameters defaultParameters(void);
+void growOnSuccess(Parameters *params, const Parameters *initial, SuccessWindow *window, bool success);
+void initEngine(Engine *engine, uint64_t seed, uint64_t stream);
+Engine* createEngine(uint64_t seed, uint64_t stream);
+void clearEngine(Engine *engine);
+void freeEngine(Engine *engine);
+BufferPool* enginePool(Engine *engine, int n_polygons);
+void printImprovement(void *data, const Solution *sol, int iteration, double score);
+void reportImprovement(Engine *engine, const Solution *sol, int iteration, double score);
+double monotonicTime(void);
+void setTimeBudget(Engine *engine, double seconds);
+bool deadlineReached(Engine *engine);
+
+// To be called once per iteration. The clock is only read every TIME_CHECK_PERIOD iterations,
+// and engines then stop and leave the best-so-far solution in 'sol'.
+static inline bool timeIsUp(Engine *engine, int iteration)
+{
+	if (engine->expired)
+		return true;
+	return engine->deadline > 0. && (iteration & (TIME_CHECK_PERIOD - 1)) == 0 && deadlineReached(engine);
+}
+
+#endif
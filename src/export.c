@@ -0,0 +1,222 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "export.h"
+#include "drawing.h"
+#include "settings.h"
+
+// Same colors as the animation window:
+#define SVG_BACKGROUND ("black")
+#define SVG_SEGMENTS   ("yellow")
+#define SVG_POINTS     ("lime")
+
+static const uint8_t Black[3]  = {0, 0, 0};
+static const uint8_t Yellow[3] = {255, 255, 0};
+static const uint8_t Lime[3]   = {0, 255, 0};
+
+/////////////////////////////////////////////
+// SVG:
+/////////////////////////////////////////////
+
+bool exportSVG(Solution sol, const char *filename)
+{
+	FILE *file = fopen(filename, "w");
+	if (!file) {
+		printf("Cannot open '%s' for writing.\n", filename);
+		return false;
+	}
+
+	Point offset = {0}; double scale = 0.;
+	computeProjection(sol, &offset, &scale);
+
+	fprintf(file, "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"%d\" height=\"%d\">\n",
+		WINDOW_WIDTH, WINDOW_HEIGHT);
+	fprintf(file, "<rect width=\"100%%\" height=\"100%%\" fill=\"%s\"/>\n", SVG_BACKGROUND);
+
+	for (int i = 0; i < sol.n_polygons; ++i) {
+		fprintf(file, "<polygon fill=\"none\" stroke=\"%s\" points=\"", SVG_SEGMENTS);
+		for (int j = 0; j < N_SIDES; ++j) {
+			const Point p = projection(sol.polArray[i].points[j], offset, scale);
+			fprintf(file, "%.3f,%.3f ", p.x, p.y);
+		}
+		fprintf(file, "\"/>\n");
+		for (int j = 0; j < N_SIDES; ++j) {
+			const Point p = projection(sol.polArray[i].points[j], offset, scale);
+			fprintf(file, "<rect x=\"%.3f\" y=\"%.3f\" width=\"%d\" height=\"%d\" fill=\"%s\"/>\n",
+				p.x - POINT_SIZE / 2, p.y - POINT_SIZE / 2, POINT_SIZE, POINT_SIZE, SVG_POINTS);
+		}
+	}
+
+	fprintf(file, "<g fill=\"%s\" font-family=\"serif\" font-weight=\"bold\" font-size=\"%d\">\n",
+		SVG_SEGMENTS, FONT_SIZE);
+	fprintf(file, "<text x=\"50\" y=\"%d\">Polygons sides: %d and number: %d</text>\n",
+		50 + FONT_SIZE, N_SIDES, sol.n_polygons);
+	fprintf(file, "<text x=\"50\" y=\"%d\">Error ratio: %.4f</text>\n", 100 + FONT_SIZE, sol.error);
+	fprintf(file, "<text x=\"50\" y=\"%d\">Big square size: %.4f</text>\n", 150 + FONT_SIZE, sol.bigSquareSide);
+	fprintf(file, "</g>\n</svg>\n");
+
+	fclose(file);
+	return true;
+}
+
+/////////////////////////////////////////////
+// Software rasterization:
+/////////////////////////////////////////////
+
+typedef struct
+{
+	int width, height;
+	uint8_t *pixels; // RGB, row by row.
+} Image;
+
+static void setPixel(Image *image, int x, int y, const uint8_t color[3])
+{
+	if (x < 0 || y < 0 || x >= image->width || y >= image->height)
+		return;
+	memcpy(image->pixels + 3 * (y * image->width + x), color, 3);
+}
+
+static void rasterPoint(Image *image, const Point *p, const uint8_t color[3])
+{
+	const int x0 = p->x - POINT_SIZE / 2, y0 = p->y - POINT_SIZE / 2;
+	for (int y = y0; y < y0 + POINT_SIZE; ++y) {
+		for (int x = x0; x < x0 + POINT_SIZE; ++x)
+			setPixel(image, x, y, color);
+	}
+}
+
+// DDA line drawing.
+static void rasterSegment(Image *image, const Point *A, const Point *B, const uint8_t color[3])
+{
+	const double dx = B->x - A->x, dy = B->y - A->y;
+	const int steps = (int) fmax(fabs(dx), fabs(dy)) + 1;
+	for (int k = 0; k <= steps; ++k) {
+		const double t = k / (double) steps;
+		setPixel(image, (int) lround(A->x + t * dx), (int) lround(A->y + t * dy), color);
+	}
+}
+
+/////////////////////////////////////////////
+// PNG encoding, with uncompressed deflate blocks:
+/////////////////////////////////////////////
+
+static uint32_t crc32Update(const uint32_t table[256], uint32_t crc, const uint8_t *data, size_t length)
+{
+	for (size_t i = 0; i < length; ++i)
+		crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+	return crc;
+}
+
+static void writeUint32(uint8_t *dest, uint32_t value)
+{
+	dest[0] = value >> 24; dest[1] = value >> 16; dest[2] = value >> 8; dest[3] = value;
+}
+
+static void writeChunk(FILE *file, const uint32_t table[256], const char *type, const uint8_t *data, uint32_t length)
+{
+	uint8_t buffer[4];
+	writeUint32(buffer, length);
+	fwrite(buffer, 1, 4, file);
+	fwrite(type, 1, 4, file);
+	fwrite(data, 1, length, file);
+	uint32_t crc = crc32Update(table, 0xffffffffu, (const uint8_t*) type, 4);
+	crc = crc32Update(table, crc, data, length) ^ 0xffffffffu;
+	writeUint32(buffer, crc);
+	fwrite(buffer, 1, 4, file);
+}
+
+static bool writePNG(const Image *image, const char *filename)
+{
+	FILE *file = fopen(filename, "wb");
+	if (!file) {
+		printf("Cannot open '%s' for writing.\n", filename);
+		return false;
+	}
+
+	uint32_t table[256];
+	for (uint32_t n = 0; n < 256; ++n) {
+		uint32_t c = n;
+		for (int k = 0; k < 8; ++k)
+			c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+		table[n] = c;
+	}
+
+	// Raw scanlines, each one starting with the 'None' filter type:
+	const size_t rowSize = 1 + 3 * (size_t) image->width;
+	const size_t rawSize = rowSize * image->height;
+	uint8_t *raw = (uint8_t*) malloc(rawSize);
+	for (int y = 0; y < image->height; ++y) {
+		raw[y * rowSize] = 0;
+		memcpy(raw + y * rowSize + 1, image->pixels + 3 * (size_t) y * image->width, rowSize - 1);
+	}
+
+	// zlib stream made of stored blocks of at most 65535 bytes:
+	const size_t blocks = (rawSize + 65534) / 65535;
+	uint8_t *zlib = (uint8_t*) malloc(2 + 5 * blocks + rawSize + 4);
+	size_t pos = 0, done = 0;
+	zlib[pos++] = 0x78; zlib[pos++] = 0x01;
+	uint32_t a = 1, b = 0; // Adler-32
+	while (done < rawSize) {
+		const uint16_t length = rawSize - done > 65535 ? 65535 : rawSize - done;
+		zlib[pos++] = done + length == rawSize;
+		zlib[pos++] = length & 0xff; zlib[pos++] = length >> 8;
+		zlib[pos++] = ~length & 0xff; zlib[pos++] = (~length >> 8) & 0xff;
+		memcpy(zlib + pos, raw + done, length);
+		for (size_t i = 0; i < length; ++i) {
+			a = (a + raw[done + i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		pos += length;
+		done += length;
+	}
+	writeUint32(zlib + pos, b << 16 | a);
+	pos += 4;
+
+	uint8_t header[13];
+	writeUint32(header, image->width);
+	writeUint32(header + 4, image->height);
+	header[8] = 8;  // bit depth
+	header[9] = 2;  // truecolor
+	header[10] = 0; // compression
+	header[11] = 0; // filter
+	header[12] = 0; // no interlace
+
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+	fwrite(signature, 1, 8, file);
+	writeChunk(file, table, "IHDR", header, 13);
+	writeChunk(file, table, "IDAT", zlib, pos);
+	writeChunk(file, table, "IEND", NULL, 0);
+
+	free(zlib);
+	free(raw);
+	fclose(file);
+	return true;
+}
+
+// Same drawing as the animation window, without the text.
+bool exportPNG(Solution sol, const char *filename)
+{
+	Image image = {WINDOW_WIDTH, WINDOW_HEIGHT, NULL};
+	image.pixels = (uint8_t*) malloc(3 * WINDOW_WIDTH * WINDOW_HEIGHT);
+	for (int k = 0; k < WINDOW_WIDTH * WINDOW_HEIGHT; ++k)
+		memcpy(image.pixels + 3 * k, Black, 3);
+
+	Point offset = {0}; double scale = 0.;
+	computeProjection(sol, &offset, &scale);
+
+	for (int i = 0; i < sol.n_polygons; ++i) {
+		Point projected[N_SIDES];
+		for (int j = 0; j < N_SIDES; ++j)
+			projected[j] = projection(sol.polArray[i].points[j], offset, scale);
+		for (int j = 0; j < N_SIDES; ++j)
+			rasterSegment(&image, projected + j, projected + (j+1) % N_SIDES, Yellow);
+		for (int j = 0; j < N_SIDES; ++j)
+			rasterPoint(&image, projected + j, Lime);
+	}
+
+	const bool res = writePNG(&image, filename);
+	free(image.pixels);
+	return res;
+}
@@ -0,0 +1,11 @@
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include <stdbool.h>
+#include "polygons.h"
+
+// Both exports use the same framing as the animation window, and do not need SDL.
+bool exportSVG(Solution sol, const char *filename);
+bool exportPNG(Solution sol, const char *filename);
+
+#endif
@@ -448,7 +448,9 @@ int findIntersection(const Polygon *pol1, const Polygon *pol2, Point allIntersec
 	return idx;
 }
 
+#ifdef USE_SDL2
 #include "drawing.h" // for debugging
+#endif
 
 double intersectionArea(const Polygon *pol1, const Polygon *pol2)
 {
@@ -510,3 +512,123 @@ double intersectionArea(const Polygon *pol1, const Polygon *pol2)
 	}
 	return totalArea1;
 }
+
+/////////////////////////////////////////////
+// Convex clipping:
+/////////////////////////////////////////////
+
+// Area of the given simple polygon, using the shoelace formula:
+double polygonArea(const Point *points, int length)
+{
+	double area = 0.;
+	for (int i = 0; i < length; ++i)
+		area += detFromPoints(points + i, points + (i+1) % length);
+	return fabs(area) / 2.;
+}
+
+// Signed distance-like value of 'p' to the line, positive on the side of 'ref'.
+static inline double sideValue(const Line *line, const Point *ref, const Point *p)
+{
+	const double sign = line->a * ref->x + line->b * ref->y + line->c >= 0. ? 1. : -1.;
+	return sign * (line->a * p->x + line->b * p->y + line->c);
+}
+
+// Clips the segment [A, B] to the given convex polygon. Returns false if nothing is left,
+// else fills the remaining segment [start, end].
+bool clipSegment(const Point *A, const Point *B, const Point *clipPoints, int clipLength, Point *start, Point *end)
+{
+	const Point center = getCenter(clipPoints, clipLength);
+	double tmin = 0., tmax = 1.;
+	for (int i = 0; i < clipLength; ++i) {
+		const Line line = lineFromPoints(clipPoints + i, clipPoints + (i+1) % clipLength);
+		const double fA = sideValue(&line, &center, A);
+		const double fB = sideValue(&line, &center, B);
+		if (fA < 0. && fB < 0.)
+			return false;
+		if (fA < 0.)
+			tmin = fmax(tmin, fA / (fA - fB));
+		else if (fB < 0.)
+			tmax = fmin(tmax, fA / (fA - fB));
+	}
+	if (tmax <= tmin)
+		return false;
+	*start = (Point) {A->x + tmin * (B->x - A->x), A->y + tmin * (B->y - A->y)};
+	*end   = (Point) {A->x + tmax * (B->x - A->x), A->y + tmax * (B->y - A->y)};
+	return true;
+}
+
+// Clips the convex polygon 'points' to the convex polygon 'clipPoints' (Sutherland-Hodgman).
+// 'result' must have room for length + clipLength points. Returns the number of points of the result.
+int clipPolygon(const Point *points, int length, const Point *clipPoints, int clipLength, Point *result)
+{
+	const int capacity = length + clipLength;
+	Point buffer[capacity];
+	memcpy(result, points, length * sizeof(Point));
+	int count = length;
+
+	const Point center = getCenter(clipPoints, clipLength);
+	for (int i = 0; i < clipLength && count > 0; ++i) {
+		const Line line = lineFromPoints(clipPoints + i, clipPoints + (i+1) % clipLength);
+		memcpy(buffer, result, count * sizeof(Point));
+		const int previousCount = count;
+		count = 0;
+		for (int k = 0; k < previousCount; ++k) {
+			const Point *P = buffer + k, *Q = buffer + (k+1) % previousCount;
+			const double fP = sideValue(&line, &center, P);
+			const double fQ = sideValue(&line, &center, Q);
+			if (fP >= 0.)
+				result[count++] = *P;
+			if ((fP >= 0.) != (fQ >= 0.)) {
+				const double t = fP / (fP - fQ);
+				result[count++] = (Point) {P->x + t * (Q->x - P->x), P->y + t * (Q->y - P->y)};
+			}
+		}
+	}
+	return count;
+}
+
+/////////////////////////////////////////////
+// Distances:
+/////////////////////////////////////////////
+
+// Squared distance from P to the segment [A, B], 'closest' being set to the closest point of the segment.
+static double pointSegmentDistance2(const Point *P, const Point *A, const Point *B, Point *closest)
+{
+	const double ex = B->x - A->x, ey = B->y - A->y;
+	const double s = fmin(fmax(((P->x - A->x) * ex + (P->y - A->y) * ey) / (ex * ex + ey * ey), 0.), 1.);
+	*closest = (Point) {A->x + s * ex, A->y + s * ey};
+	return distance2(P, closest);
+}
+
+double pointSegmentDistance(const Point *P, const Point *A, const Point *B, Point *closest)
+{
+	return sqrt(pointSegmentDistance2(P, A, B, closest));
+}
+
+double polygonsDistance(const Point *points1, int length1, const Point *points2, int length2, Point *A, Point *B)
+{
+	double dist2 = INFINITY;
+	for (int i = 0; i < length2; ++i) {
+		for (int j = 0; j < length1; ++j) {
+			Point H;
+			const double d2 = pointSegmentDistance2(points1 + j, points2 + i, points2 + (i+1) % length2, &H);
+			if (d2 < dist2) {
+				dist2 = d2;
+				*A = points1[j];
+				*B = H;
+			}
+		}
+	}
+	for (int i = 0; i < length1; ++i) {
+		for (int j = 0; j < length2; ++j) {
+			Point H;
+			const double d2 = pointSegmentDistance2(points2 + j, points1 + i, points1 + (i+1) % length1, &H);
+			if (d2 < dist2) {
+				dist2 = d2;
+				*A = H;
+				*B = points2[j];
+			}
+		}
+	}
+	return sqrt(dist2);
+}
@@ -26,6 +26,7 @@ typedef struct
 {
 	Point points[N_SIDES];
 	Point center; // put this as the array last spot?
+	double angle; // rotation since createPolygon()
 } Polygon; // polygon area = 1.
 
 // TODO: inline short functions
@@ -147,4 +148,30 @@ double area2(const Point *A, const Point *B, const Point *C);
 
 double intersectionArea(const Polygon *pol1, const Polygon *pol2);
 
+/////////////////////////////////////////////
+// Convex clipping, for any convex polygon given by its points in order:
+/////////////////////////////////////////////
+
+// Area of the given simple polygon, using the shoelace formula:
+double polygonArea(const Point *points, int length);
+
+// Clips the segment [A, B] to the given convex polygon. Returns false if nothing is left,
+// else fills the remaining segment [start, end].
+bool clipSegment(const Point *A, const Point *B, const Point *clipPoints, int clipLength, Point *start, Point *end);
+
+// Clips the convex polygon 'points' to the convex polygon 'clipPoints' (Sutherland-Hodgman).
+// 'result' must have room for length + clipLength points. Returns the number of points of the result.
+int clipPolygon(const Point *points, int length, const Point *clipPoints, int clipLength, Point *result);
+
+/////////////////////////////////////////////
+// Distances:
+/////////////////////////////////////////////
+
+// Distance from P to the segment [A, B], 'closest' being set to the closest point of the segment.
+double pointSegmentDistance(const Point *P, const Point *A, const Point *B, Point *closest);
+
+// Distance between two disjoint convex polygons, reached between a vertex and an edge.
+// 'A' and 'B' are set to the closest points, on the first and second polygon respectively.
+double polygonsDistance(const Point *points1, int length1, const Point *points2, int length2, Point *A, Point *B);
+
 #endif
@@ -0,0 +1,136 @@
+#define _POSIX_C_SOURCE 200112L // for posix_memalign() and nanosleep()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "logger.h"
+
+static void writeEvent(Logger *logger, const LogEvent *event)
+{
+	if (logger->binary)
+		fwrite(event, sizeof(LogEvent), 1, logger->file);
+	else if (logger->n_rings > 1)
+		fprintf(logger->file, "Engine %d, improvement at iteration %d: %.4f\n", event->ring, event->iteration, event->score);
+	else
+		fprintf(logger->file, "Improvement at iteration %d: %.4f\n", event->iteration, event->score);
+}
+
+// At most LOG_RATE events are written per second. Events arriving in between are
+// coalesced, only the last one being kept for the next write.
+static bool handleEvent(Logger *logger, const LogEvent *event, double now)
+{
+	if (LOG_RATE > 0 && now - logger->lastWrite < 1. / LOG_RATE) {
+		logger->skipped += logger->pending;
+		logger->last = *event;
+		logger->pending = true;
+		return false;
+	}
+	writeEvent(logger, event);
+	logger->lastWrite = now;
+	logger->pending = false;
+	return true;
+}
+
+// Returns true if something has been written.
+static bool drain(Logger *logger, bool final)
+{
+	const double now = monotonicTime();
+	bool written = false;
+	for (int r = 0; r < logger->n_rings; ++r) {
+		LogRing *ring = logger->rings + r;
+		const uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+		uint64_t tail = ring->tail;
+		for (; tail != head; ++tail)
+			written |= handleEvent(logger, ring->events + (tail & (LOG_RING_SIZE - 1)), now);
+		__atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+	}
+	if (logger->pending && (final || now - logger->lastWrite >= 1. / LOG_RATE))
+		written |= handleEvent(logger, &logger->last, final ? INFINITY : now);
+	if (written)
+		fflush(logger->file);
+	return written;
+}
+
+static void* loggerLoop(void *arg)
+{
+	Logger *logger = (Logger*) arg;
+	const struct timespec period = {0, LOG_PERIOD_MS * 1000000L};
+	while (!__atomic_load_n(&logger->stop, __ATOMIC_ACQUIRE)) {
+		drain(logger, false);
+		nanosleep(&period, NULL);
+	}
+	drain(logger, true);
+	return NULL;
+}
+
+// Writes to 'filename', or to stdout if NULL. Each search thread needs its own ring.
+Logger* startLogger(const char *filename, bool binary, int n_rings)
+{
+	Logger *logger = (Logger*) calloc(1, sizeof(Logger));
+	logger->file = filename ? fopen(filename, binary ? "wb" : "w") : stdout;
+	if (!logger->file) {
+		printf("Cannot open '%s' for writing.\n", filename);
+		exit(1);
+	}
+	void *memory = NULL;
+	if (posix_memalign(&memory, CACHE_LINE, n_rings * sizeof(LogRing))) {
+		printf("Cannot allocate the log rings.\n");
+		exit(1);
+	}
+	logger->rings = (LogRing*) memory;
+	memset(logger->rings, 0, n_rings * sizeof(LogRing));
+	for (int r = 0; r < n_rings; ++r)
+		logger->rings[r].index = r;
+	logger->n_rings = n_rings;
+	logger->binary = binary;
+	logger->lastWrite = -INFINITY;
+	if (pthread_create(&logger->thread, NULL, loggerLoop, logger)) {
+		printf("Cannot create the logger thread.\n");
+		exit(1);
+	}
+	return logger;
+}
+
+// Writes what is left, then frees the logger. Search threads must be done logging.
+void stopLogger(Logger *logger)
+{
+	__atomic_store_n(&logger->stop, 1, __ATOMIC_RELEASE);
+	pthread_join(logger->thread, NULL);
+
+	uint64_t dropped = 0;
+	for (int r = 0; r < logger->n_rings; ++r)
+		dropped += logger->rings[r].dropped;
+	if (!logger->binary && (logger->skipped || dropped))
+		fprintf(logger->file, "Log: %lu improvements skipped by the rate limit, %lu dropped.\n",
+			(unsigned long) logger->skipped, (unsigned long) dropped);
+
+	if (logger->file != stdout)
+		fclose(logger->file);
+	else
+		fflush(stdout);
+	free(logger->rings);
+	free(logger);
+}
+
+void attachLogger(Engine *engine, Logger *logger, int ring)
+{
+	engine->onImprovement = logImprovement;
+	engine->sinkData = logger->rings + ring;
+}
+
+// Improvement sink for search threads: only a copy into the ring, no syscall and no lock.
+// Events are dropped when the ring is full.
+void logImprovement(void *data, const Solution *sol, int iteration, double score)
+{
+	(void) sol;
+	LogRing *ring = (LogRing*) data;
+	const uint64_t head = ring->head;
+	if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= LOG_RING_SIZE) {
+		__atomic_fetch_add(&ring->dropped, 1, __ATOMIC_RELAXED);
+		return;
+	}
+	ring->events[head & (LOG_RING_SIZE - 1)] = (LogEvent) {ring->index, iteration, score};
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,50 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "settings.h"
+#include "engine.h"
+
+// Improvement event, as pushed by a search thread. Also the record of the binary output.
+typedef struct
+{
+	int32_t ring;
+	int32_t iteration;
+	double score;
+} LogEvent;
+
+// Lock-free ring buffer between one search thread and the logger thread. Head and tail
+// live on separate cache lines, each one being written by a single thread.
+typedef struct
+{
+	LogEvent events[LOG_RING_SIZE];
+	int32_t index;
+	uint64_t head __attribute__((aligned(CACHE_LINE))); // next write, by the search thread. Atomic.
+	uint64_t dropped;                                   // events lost to a full ring. Atomic.
+	uint64_t tail __attribute__((aligned(CACHE_LINE))); // next read, by the logger thread. Atomic.
+} LogRing;
+
+typedef struct
+{
+	LogRing *rings; // one per search thread
+	int n_rings;
+	FILE *file;
+	bool binary;
+	int stop; // atomic
+	pthread_t thread;
+	// Logger thread only:
+	double lastWrite;
+	bool pending; // an event waiting for the rate limit
+	LogEvent last;
+	uint64_t skipped;
+} Logger;
+
+Logger* startLogger(const char *filename, bool binary, int n_rings);
+void stopLogger(Logger *logger);
+void attachLogger(Engine *engine, Logger *logger, int ring);
+void logImprovement(void *data, const Solution *sol, int iteration, double score);
+
+#endif
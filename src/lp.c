@@ -0,0 +1,130 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lp.h"
+
+#define LP_EPSILON (1.e-12)
+
+LinearProgram* createLinearProgram(int n_vars)
+{
+	LinearProgram *lp = (LinearProgram*) calloc(1, sizeof(LinearProgram));
+	lp->n_vars = n_vars;
+	lp->objective = (double*) calloc(n_vars + 1, sizeof(double));
+	lp->nonbasic = (int*) calloc(n_vars, sizeof(int));
+	lp->nonzeros = (int*) calloc(n_vars + 1, sizeof(int));
+	lpClear(lp);
+	return lp;
+}
+
+void freeLinearProgram(LinearProgram *lp)
+{
+	if (!lp)
+		return;
+	free(lp->table);
+	free(lp->objective);
+	free(lp->basis);
+	free(lp->nonbasic);
+	free(lp->nonzeros);
+	free(lp);
+}
+
+// Removes all rows and the objective, keeping the memory.
+void lpClear(LinearProgram *lp)
+{
+	lp->n_rows = 0;
+	memset(lp->objective, 0, (lp->n_vars + 1) * sizeof(double));
+	for (int j = 0; j < lp->n_vars; ++j)
+		lp->nonbasic[j] = j;
+}
+
+// Returns the zeroed coefficients of the new row, to be filled by the caller.
+double* lpAddRow(LinearProgram *lp, double bound)
+{
+	const int width = lp->n_vars + 1;
+	if (lp->n_rows == lp->capacity) {
+		lp->capacity = lp->capacity ? 2 * lp->capacity : 64;
+		lp->table = (double*) realloc(lp->table, lp->capacity * width * sizeof(double));
+		lp->basis = (int*) realloc(lp->basis, lp->capacity * sizeof(int));
+	}
+	double *row = lp->table + lp->n_rows * width;
+	memset(row, 0, width * sizeof(double));
+	row[lp->n_vars] = bound;
+	lp->basis[lp->n_rows] = lp->n_vars + lp->n_rows;
+	++lp->n_rows;
+	return row;
+}
+
+void lpSetObjective(LinearProgram *lp, int var, double coefficient)
+{
+	lp->objective[var] = -coefficient;
+}
+
+// Exchanges basis[r] and nonbasic[s].
+static void pivot(LinearProgram *lp, int r, int s)
+{
+	const int width = lp->n_vars + 1;
+	double *a = lp->table + r * width;
+	const double inv = 1. / a[s];
+	// Rows are sparse, e.g the trust region ones: only the nonzeros of the pivot row matter.
+	int n_nonzeros = 0;
+	for (int j = 0; j < width; ++j) {
+		if (a[j] != 0.)
+			lp->nonzeros[n_nonzeros++] = j;
+	}
+	for (int i = 0; i <= lp->n_rows; ++i) {
+		double *d = i < lp->n_rows ? lp->table + i * width : lp->objective;
+		if (i == r || d[s] == 0.)
+			continue;
+		const double f = d[s] * inv;
+		for (int k = 0; k < n_nonzeros; ++k)
+			d[lp->nonzeros[k]] -= f * a[lp->nonzeros[k]];
+		d[s] = -f;
+	}
+	for (int j = 0; j < width; ++j)
+		a[j] *= inv;
+	a[s] = inv;
+
+	const int var = lp->basis[r];
+	lp->basis[r] = lp->nonbasic[s];
+	lp->nonbasic[s] = var;
+}
+
+// Bland's rule, which cannot cycle: the LPs of interest are highly degenerate. Returns false if the
+// LP is unbounded or 'maxPivots' has been reached, 'x' then being the last basic solution.
+bool lpSolve(LinearProgram *lp, int maxPivots, double *x)
+{
+	const int width = lp->n_vars + 1;
+	bool optimal = false;
+	for (int p = 0; p < maxPivots; ++p) {
+		int s = -1;
+		for (int j = 0; j < lp->n_vars; ++j) {
+			if (lp->objective[j] < -LP_EPSILON && (s < 0 || lp->nonbasic[j] < lp->nonbasic[s]))
+				s = j;
+		}
+		if (s < 0) {
+			optimal = true;
+			break;
+		}
+		int r = -1;
+		double best = 0.;
+		for (int i = 0; i < lp->n_rows; ++i) {
+			const double *d = lp->table + i * width;
+			if (d[s] <= LP_EPSILON)
+				continue;
+			const double ratio = d[lp->n_vars] / d[s];
+			if (r < 0 || ratio < best || (ratio == best && lp->basis[i] < lp->basis[r])) {
+				r = i;
+				best = ratio;
+			}
+		}
+		if (r < 0)
+			break; // unbounded
+		pivot(lp, r, s);
+	}
+	memset(x, 0, lp->n_vars * sizeof(double));
+	for (int i = 0; i < lp->n_rows; ++i) {
+		if (lp->basis[i] < lp->n_vars)
+			x[lp->basis[i]] = lp->table[i * width + lp->n_vars];
+	}
+	return optimal;
+}
@@ -0,0 +1,26 @@
+#ifndef LP_H
+#define LP_H
+
+#include <stdbool.h>
+
+// Dense simplex for small linear programs of the form: maximize c.x, subject to A.x <= b and x >= 0,
+// with b >= 0 so that x = 0 is feasible. Stored as a dictionary: row i holds the basic variable
+// basis[i] in terms of the nonbasic ones, the last column being the right hand side. Variables are
+// numbered 0, ..., n_vars-1, then the slacks of the rows.
+typedef struct
+{
+	int n_vars, n_rows, capacity;
+	double *table;     // rows of n_vars + 1
+	double *objective; // n_vars + 1, negated coefficients then the value
+	int *basis, *nonbasic;
+	int *nonzeros; // pivot row scratch
+} LinearProgram;
+
+LinearProgram* createLinearProgram(int n_vars);
+void freeLinearProgram(LinearProgram *lp);
+void lpClear(LinearProgram *lp);
+double* lpAddRow(LinearProgram *lp, double bound);
+void lpSetObjective(LinearProgram *lp, int var, double coefficient);
+bool lpSolve(LinearProgram *lp, int maxPivots, double *x);
+
+#endif
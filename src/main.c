@@ -1,57 +1,121 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
 #include <math.h>
 #include <time.h>
 #include <assert.h>
 #include "polygons.h"
 #include "drawing.h"
 #include "search.h"
+#include "export.h"
+#include "relax.h"
+#include "logger.h"
+#include "decompose.h"
+#include "swept.h"
+#include "critical.h"
+#include "compress.h"
+#include "moves.h"
+#include "tune.h"
 
 void testIntersection(void);
 void testPolygonCreation(rng_type *rng);
-void testIntersectionArea(int n_polygons, rng_type *rng);
+void testIntersectionArea(int n_polygons);
 void testOriginsLinked(rng_type *rng);
 void testIsPointInHalfPlane(void);
-
-SDL_Window *window = NULL;
-SDL_Renderer *renderer = NULL;
+void testPolishThenFeasibility(void);
 
 int main(int argc, char const *argv[])
 {
-	initConstExpr();
+	if (argc > 1 && strcmp(argv[1], "tune") == 0) {
+		const int defaultSizes[] = TUNE_SIZES;
+		const int n_sizes = argc > 2 ? argc - 2 : (int) (sizeof(defaultSizes) / sizeof(int));
+		int sizes[n_sizes];
+		for (int s = 0; s < n_sizes; ++s) {
+			sizes[s] = argc > 2 ? atoi(argv[s + 2]) : defaultSizes[s];
+			if (sizes[s] <= 0) {
+				printf("Invalid number of polygons: '%s'.\n", argv[s + 2]);
+				return 1;
+			}
+		}
+		return tuneParameters(sizes, n_sizes, PARAMS_FILE) ? 0 : 1;
+	}
 
 	const int n_polygons = 5;
 
 	// const uint64_t seed = time(NULL);
 	const uint64_t seed = 123456;
 	printf("seed: %lu\n", seed);
-	rng_type rng = {0};
-	rng_init(&rng, seed, 0);
+	Engine engine;
+	initEngine(&engine, seed, 0);
+	if (loadParameters(PARAMS_FILE, n_polygons, &engine.params))
+		printf("Parameters loaded from '%s'.\n", PARAMS_FILE);
 
 	// testIntersection();
-	// testPolygonCreation(&rng);
-	// testIntersectionArea(n_polygons, &rng);
-	// testOriginsLinked(&rng);
+	// testPolygonCreation(&engine.rng);
+	// testIntersectionArea(n_polygons);
+	// testOriginsLinked(&engine.rng);
 	// testIsPointInHalfPlane();
+	// testPolishThenFeasibility();
 
 	// const int iterationNumber = 1000;
 	const int iterationNumber = 1000000;
 	// const int iterationNumber = 1000000 / NEIGHBOURHOOD;
 
-	Solution sol = init(n_polygons, &rng);
+	Solution sol = init(n_polygons);
 	printf("Init error ratio: %.4f\n", sol.error);
 
-	optimize(&sol, &rng, iterationNumber);
-	// optimize_2(&sol, &rng, iterationNumber);
-	// printf("OK status: %d\n", optimize_area(&sol, &rng, iterationNumber));
-	// optimize_sa(&sol, &rng, iterationNumber);
+#if defined(USE_SDL2) && defined(LIVE_RENDERING)
+	SnapshotBuffer *snapshots = createSnapshotBuffer(n_polygons);
+	publishSnapshot(snapshots, &sol, 0);
+	engine.snapshots = snapshots;
+	LiveAnimation *live = startLiveAnimation(snapshots);
+#endif
+
+#if defined(ASYNC_LOGGING) && defined(LOG_BINARY)
+	Logger *logger = startLogger(EXPORT_NAME ".log", true, 1);
+	attachLogger(&engine, logger, 0);
+#elif defined(ASYNC_LOGGING)
+	Logger *logger = startLogger(NULL, false, 1);
+	attachLogger(&engine, logger, 0);
+#endif
+
+	setTimeBudget(&engine, TIME_BUDGET);
+	runOptimizer(&engine, &sol, iterationNumber); // optimize_moves() unless tuned otherwise
+	// optimize_2(&engine, &sol, iterationNumber);
+	// printf("OK status: %d\n", optimize_area(&engine, &sol, iterationNumber));
+	// optimize_sa(&engine, &sol, iterationNumber);
+	// optimize_relax(&engine, &sol, 20000); // few steps needed
+	// optimize_feasibility(&engine, &sol, iterationNumber);
+	// optimize_tiles(&engine, &sol, iterationNumber); // for large n
+	// optimize_swept(&engine, &sol, iterationNumber); // needs a valid configuration
+	// optimize_critical(&engine, &sol, iterationNumber); // needs a valid configuration
+	// optimize_compress(&engine, &sol, iterationNumber); // needs a valid configuration, for large n
+	// optimize_moves(&engine, &sol, iterationNumber); // needs a valid configuration
+
+#ifdef ASYNC_LOGGING
+	stopLogger(logger);
+	engine.onImprovement = NULL;
+#endif
 
 	printf("Best error ratio: %f\n", sol.error);
 	printf("Best big square side: %f\n\n", sol.bigSquareSide);
 
+	exportSVG(sol, EXPORT_NAME ".svg");
+#ifdef EXPORT_PNG
+	exportPNG(sol, EXPORT_NAME ".png");
+#endif
+
+#if defined(USE_SDL2) && defined(LIVE_RENDERING)
+	publishSnapshot(snapshots, &sol, iterationNumber);
+	waitLiveAnimation(live);
+	engine.snapshots = NULL;
+	freeSnapshotBuffer(snapshots);
+#elif defined(USE_SDL2)
 	animation(sol);
+#endif
 
+	clearEngine(&engine);
 	free(sol.polArray);
 	return 0;
 }
@@ -82,9 +146,9 @@ void testPolygonCreation(rng_type *rng)
 	exit(0);
 }
 
-void testIntersectionArea(int n_polygons, rng_type *rng)
+void testIntersectionArea(int n_polygons)
 {
-	const Solution sol = init(n_polygons, rng);
+	const Solution sol = init(n_polygons);
 	for (int i = 0; i < n_polygons; ++i) {
 		for (int j = i+1; j < n_polygons; ++j) {
 			const double area = intersectionArea(sol.polArray + i, sol.polArray + j);
@@ -92,7 +156,9 @@ void testIntersectionArea(int n_polygons, rng_type *rng)
 				printf("Non zero-area for (%d, %d): %g\n", i, j, area);
 		}
 	}
+#ifdef USE_SDL2
 	animation(sol);
+#endif
 	exit(0);
 }
 
@@ -111,6 +177,24 @@ void testOriginsLinked(rng_type *rng)
 	exit(0);
 }
 
+// Regression: polished configurations used to have touching pairs, on which the area based engines exited.
+void testPolishThenFeasibility(void)
+{
+	const int n_polygons = 30;
+	for (uint64_t seed = 1; seed <= 4; ++seed) {
+		Engine engine;
+		initEngine(&engine, seed, 0);
+		engine.onImprovement = NULL;
+		Solution sol = init(n_polygons);
+		optimize(&engine, &sol, 20000); // polishes at the end
+		optimize_feasibility(&engine, &sol, 200000);
+		printf("Seed %lu: error %.4f, valid: %d\n", seed, sol.error, checkConfiguration(sol.polArray, n_polygons));
+		clearEngine(&engine);
+		free(sol.polArray);
+	}
+	exit(0);
+}
+
 void testIsPointInHalfPlane(void)
 {
 	// Very specific set of points:
@@ -0,0 +1,359 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "moves.h"
+#include "critical.h"
+#include "polish.h"
+
+// Rotation of 'pol' as a rigid body around 'pivot', which is taken by value since it may be a vertex of 'pol'.
+static void rigidRotation(Polygon *pol, Point pivot, double angle)
+{
+	const Point center = rotatePoint(pivot, pol->center, cos(angle), sin(angle));
+	rotation(pol, angle);
+	translation(pol, center.x - pol->center.x, center.y - pol->center.y);
+}
+
+// Indices of the polygons whose center is within 'reach' of the one of 'idx', 'idx' excluded.
+static int neighbours(const Polygon *polArray, int n_polygons, int idx, double reach, int *result)
+{
+	int count = 0;
+	for (int j = 0; j < n_polygons; ++j) {
+		if (j != idx && distance2(&(polArray[idx].center), &(polArray[j].center)) < reach * reach)
+			result[count++] = j;
+	}
+	return count;
+}
+
+// Same as signedMutation().
+static int translateMove(rng_type *rng, const Parameters *params, Polygon *polArray, int n_polygons,
+	int idx, int *moved, Polygon *saved)
+{
+	(void) n_polygons;
+	moved[0] = idx;
+	saved[0] = polArray[idx];
+	signedMutation(rng, params, polArray + idx);
+	return 1;
+}
+
+// Rotation around one of the polygon corners, e.g one touching a neighbour or the box.
+static int pivotMove(rng_type *rng, const Parameters *params, Polygon *polArray, int n_polygons,
+	int idx, int *moved, Polygon *saved)
+{
+	(void) n_polygons;
+	moved[0] = idx;
+	saved[0] = polArray[idx];
+	const int corner = rng_int(rng) % N_SIDES;
+	const double angle = (rng_real(rng) - 0.5) * params->rotationProba;
+	rigidRotation(polArray + idx, polArray[idx].points[corner], angle);
+	return 1;
+}
+
+// Exchanges the positions of the polygon and of a close one, each keeping its orientation.
+static int swapMove(rng_type *rng, const Parameters *params, Polygon *polArray, int n_polygons,
+	int idx, int *moved, Polygon *saved)
+{
+	const int count = neighbours(polArray, n_polygons, idx, 2. * sqrt(getDiam2()), moved + 1);
+	if (count == 0)
+		return translateMove(rng, params, polArray, n_polygons, idx, moved, saved);
+	moved[0] = idx;
+	moved[1] = moved[1 + rng_int(rng) % count];
+	Polygon *p1 = polArray + moved[0], *p2 = polArray + moved[1];
+	saved[0] = *p1;
+	saved[1] = *p2;
+	const double dx = p2->center.x - p1->center.x, dy = p2->center.y - p1->center.y;
+	translation(p1, dx, dy);
+	translation(p2, -dx, -dy);
+	return 2;
+}
+
+// Same translation for the polygon and those in contact with it, the tolerance being the step size.
+static int clusterMove(rng_type *rng, const Parameters *params, Polygon *polArray, int n_polygons,
+	int idx, int *moved, Polygon *saved)
+{
+	moved[0] = idx;
+	const int n_moved = 1 + neighbours(polArray, n_polygons, idx, sqrt(getDiam2()) + params->stepSize, moved + 1);
+	float u[2];
+	rng_fill(rng, u, 2);
+	const double dx = params->stepSize * (2.f * u[0] - 1.f), dy = params->stepSize * (2.f * u[1] - 1.f);
+	for (int k = 0; k < n_moved; ++k) {
+		saved[k] = polArray[moved[k]];
+		translation(polArray + moved[k], dx, dy);
+	}
+	return n_moved;
+}
+
+// Rotation as a rigid body of the horizontal or vertical row of the polygon, around the row centroid.
+// The angle is scaled so that no polygon center moves by more than the step size.
+static int rowMove(rng_type *rng, const Parameters *params, Polygon *polArray, int n_polygons,
+	int idx, int *moved, Polygon *saved)
+{
+	const bool horizontal = rng_int(rng) & 1;
+	const double r = getRadius();
+	const Point *c = &(polArray[idx].center);
+	Point centroid = {0., 0.};
+	int n_moved = 0;
+	for (int j = 0; j < n_polygons; ++j) {
+		const Point *cj = &(polArray[j].center);
+		if (fabs(horizontal ? cj->y - c->y : cj->x - c->x) < r) {
+			moved[n_moved++] = j;
+			centroid.x += cj->x;
+			centroid.y += cj->y;
+		}
+	}
+	centroid.x /= n_moved;
+	centroid.y /= n_moved;
+	double reach = 0.;
+	for (int k = 0; k < n_moved; ++k)
+		reach = fmax(reach, distance2(&centroid, &(polArray[moved[k]].center)));
+	const double angle = (2. * rng_real(rng) - 1.) * params->stepSize / fmax(sqrt(reach), r);
+	for (int k = 0; k < n_moved; ++k) {
+		saved[k] = polArray[moved[k]];
+		rigidRotation(polArray + moved[k], centroid, angle);
+	}
+	return n_moved;
+}
+
+// Translation drawn mostly along a direction, picked uniformly among: toward the packing centroid, toward
+// the emptiest side of the neighbourhood (away from the sum of unit vectors to the neighbours), and away
+// from the box sides the polygon touches, the tolerance being the step size. The length is uniform
+// up to the step size, with a lateral spread of half the step size. Rotations are as in mutation().
+static int directedMove(rng_type *rng, const Parameters *params, Polygon *polArray, int n_polygons,
+	int idx, int *moved, Polygon *saved)
+{
+	const double step = params->stepSize;
+	Polygon *pol = polArray + idx;
+	float u[4];
+	rng_fill(rng, u, 4);
+	Point d = {0., 0.};
+	if (u[0] < 1.f/3.f) {
+		for (int j = 0; j < n_polygons; ++j) {
+			d.x += polArray[j].center.x;
+			d.y += polArray[j].center.y;
+		}
+		d.x = d.x / n_polygons - pol->center.x;
+		d.y = d.y / n_polygons - pol->center.y;
+	}
+	else if (u[0] < 2.f/3.f) {
+		const double reach = sqrt(getDiam2()) + step;
+		for (int j = 0; j < n_polygons; ++j) {
+			const double dx = pol->center.x - polArray[j].center.x, dy = pol->center.y - polArray[j].center.y;
+			const double d2 = dx * dx + dy * dy;
+			if (j != idx && d2 < reach * reach && d2 > 0.) {
+				d.x += dx / sqrt(d2);
+				d.y += dy / sqrt(d2);
+			}
+		}
+	}
+	else {
+		const Box box = findBoundary(polArray, n_polygons), b = findBoundary(pol, 1);
+		d.x = (b.xmin - box.xmin <= step) - (box.xmax - b.xmax <= step);
+		d.y = (b.ymin - box.ymin <= step) - (box.ymax - b.ymax <= step);
+	}
+	const double norm = sqrt(d.x * d.x + d.y * d.y);
+	if (norm < EPSILON) // e.g at the centroid, or not on the box sides
+		return translateMove(rng, params, polArray, n_polygons, idx, moved, saved);
+
+	moved[0] = idx;
+	saved[0] = *pol;
+	d.x /= norm;
+	d.y /= norm;
+	const double length = step * u[1], lateral = 0.5 * step * (2.f * u[2] - 1.f);
+	translation(pol, length * d.x - lateral * d.y, length * d.y + lateral * d.x);
+	if (u[3] < params->rotationProba)
+		rotation(pol, u[3] - params->rotationProba/2.);
+	return 1;
+}
+
+void initMoveLibrary(MoveLibrary *lib)
+{
+	static const char *names[N_MOVES] = {"translate", "pivot", "swap", "cluster", "row", "directed"};
+	static const MoveOperator operators[N_MOVES] = {translateMove, pivotMove, swapMove, clusterMove, rowMove, directedMove};
+	memset(lib, 0, sizeof(MoveLibrary));
+	for (int k = 0; k < N_MOVES; ++k) {
+		lib->stats[k].name = names[k];
+		lib->stats[k].apply = operators[k];
+		lib->stats[k].time = 1.;
+	}
+}
+
+void clearMoveLibrary(MoveLibrary *lib)
+{
+	free(lib->scales);
+	lib->scales = NULL;
+	lib->n_scales = 0;
+}
+
+// The scales are reset to 1 if the number of polygons changes.
+double* moveScales(MoveLibrary *lib, int n_polygons)
+{
+	if (lib->n_scales != n_polygons) {
+		double *scales = (double*) realloc(lib->scales, n_polygons * sizeof(double));
+		if (!scales) {
+			printf("Cannot allocate the step scales.\n");
+			exit(1);
+		}
+		for (int k = 0; k < n_polygons; ++k)
+			scales[k] = 1.;
+		lib->scales = scales;
+		lib->n_scales = n_polygons;
+	}
+	return lib->scales;
+}
+
+// Roulette over the average rewards per microsecond, mixed with a uniform pick so that no operator is
+// starved: the yield of an operator changes as the packing gets denser.
+MoveKind movePick(const MoveLibrary *lib, rng_type *rng)
+{
+	double rates[N_MOVES], total = 0.;
+	for (int k = 0; k < N_MOVES; ++k) {
+		rates[k] = lib->stats[k].reward / lib->stats[k].time;
+		total += rates[k];
+	}
+	const double u = rng_real(rng);
+	if (total <= 0. || u < MOVES_EXPLORE)
+		return (MoveKind) (rng_int(rng) % N_MOVES);
+	double v = total * (u - MOVES_EXPLORE) / (1. - MOVES_EXPLORE);
+	int k = 0;
+	for (; k < N_MOVES - 1; ++k) {
+		if (v < rates[k])
+			break;
+		v -= rates[k];
+	}
+	return (MoveKind) k;
+}
+
+// 'time' is the cost of the try in microseconds.
+void moveReward(MoveLibrary *lib, MoveKind kind, bool accepted, bool improved, double reward, double time)
+{
+	MoveStats *s = lib->stats + kind;
+	++s->tries;
+	s->accepted += accepted;
+	s->improvements += improved;
+	s->reward = (1. - MOVES_RATE) * s->reward + MOVES_RATE * reward;
+	s->time = (1. - MOVES_RATE) * s->time + MOVES_RATE * time;
+}
+
+void printMoveLibrary(const MoveLibrary *lib)
+{
+	for (int k = 0; k < N_MOVES; ++k) {
+		const MoveStats *s = lib->stats + k;
+		printf("%-10s tries: %9ld, accepted: %5.2f%%, improvements: %6ld, reward/us: %.3g\n", s->name, s->tries,
+			s->tries ? 100. * s->accepted / s->tries : 0., s->improvements, s->reward / s->time);
+	}
+}
+
+// Folded into a constant by the compiler, nothing being written at runtime.
+static inline double scaleDown(void)
+{
+	return pow(MOVES_SCALE_UP, -MOVES_TARGET / (1. - MOVES_TARGET));
+}
+
+// Per polygon step scales, from each polygon own acceptance history: a success multiplies the scale
+// by MOVES_SCALE_UP, and failures shrink it so that it is stationary at MOVES_TARGET acceptance.
+void adaptStepScale(double *scale, bool accepted)
+{
+	*scale = fmin(fmax(*scale * (accepted ? MOVES_SCALE_UP : scaleDown()), MOVES_MIN_SCALE), MOVES_MAX_SCALE);
+}
+
+// Pairs made of a moved polygon and any other one, each pair of moved polygons tested once.
+bool movedCollide(const Polygon *polArray, int n_polygons, const int *moved, int n_moved, bool *mark)
+{
+	bool collide = false;
+	for (int k = 0; k < n_moved; ++k)
+		mark[moved[k]] = true;
+	for (int k = 0; k < n_moved && !collide; ++k) {
+		const int m = moved[k];
+		for (int j = 0; j < n_polygons && !collide; ++j)
+			collide = j != m && !(mark[j] && j < m) && intersects(polArray + m, polArray + j);
+	}
+	for (int k = 0; k < n_moved; ++k)
+		mark[moved[k]] = false;
+	return collide;
+}
+
+// True if fewer of the moved polygons are on the box sides than before the move, e.g a swap of
+// a polygon on a side with one behind it does not count.
+static bool leftBoundary(const CriticalSet *cs, const Polygon *polArray, const int *moved, int n_moved, const Polygon *saved)
+{
+	int balance = 0;
+	for (int k = 0; k < n_moved; ++k)
+		balance += onBoundary(cs, saved + k) - onBoundary(cs, polArray + moved[k]);
+	return balance > 0;
+}
+
+// Moves of polygons picked from the critical set if 'critical', see critical.h, or else uniformly, the
+// operator being picked from the engine move library. A move is kept if the configuration stays valid and the side does not grow,
+// so that polygons can leave the box sides one after another until the side shrinks. Rewards, of both
+// the class and the operator: 1 when the side shrinks, 1/2 when polygons leave the box sides.
+// The given solution must be valid. Returns true if it has been improved.
+bool searchMoves(Engine *engine, Solution *sol, int iterationNumber, bool critical, const char *name)
+{
+	rng_type *rng = &engine->rng;
+	const int n_polygons = sol->n_polygons;
+	Polygon *polArray = sol->polArray;
+	if (!checkConfiguration(polArray, n_polygons)) {
+		printf("%s() needs a valid configuration.\n", name);
+		return false;
+	}
+	CriticalSet *cs = createCriticalSet(polArray, n_polygons, engine->params.stepSize);
+	MoveLibrary *lib = &engine->moves;
+	BufferPool *pool = enginePool(engine, n_polygons);
+	Polygon *saved = acquireBuffer(pool);
+	int *moved = (int*) calloc(n_polygons, sizeof(int));
+	bool *mark = (bool*) calloc(n_polygons, sizeof(bool));
+	double *scales = moveScales(lib, n_polygons);
+	Parameters params = engine->params;
+	bool improved = false, stale = false;
+
+	for (int i = 0; i < iterationNumber && !timeIsUp(engine, i); ++i) {
+		if (stale || i % CRITICAL_PERIOD == 0) {
+			criticalUpdate(cs, polArray);
+			stale = false;
+		}
+		const double start = monotonicTime();
+		const MoveKind kind = movePick(lib, rng);
+		int level = 0;
+		const int idx = critical ? criticalPick(cs, rng, &level) : (int) (rng_int(rng) % n_polygons);
+		params.stepSize = engine->params.stepSize * scales[idx];
+		const int n_moved = lib->stats[kind].apply(rng, &params, polArray, n_polygons, idx, moved, saved);
+
+		double side = 0, error = 0, reward = 0.;
+		findErrorRatio(polArray, n_polygons, &side, &error);
+		const bool accepted = error <= sol->error && !movedCollide(polArray, n_polygons, moved, n_moved, mark);
+		if (!accepted) { // backtracking
+			for (int k = n_moved-1; k >= 0; --k)
+				polArray[moved[k]] = saved[k];
+		}
+		else if (error < sol->error) {
+			sol->bigSquareSide = side;
+			sol->error = error;
+			reportImprovement(engine, sol, i, error);
+			reward = 1.;
+			improved = stale = true;
+		}
+		else if (leftBoundary(cs, polArray, moved, n_moved, saved)) {
+			reward = 0.5;
+			stale = true;
+		}
+		if (critical)
+			criticalReward(cs, level, reward);
+		adaptStepScale(scales + idx, accepted);
+		moveReward(lib, kind, accepted, reward == 1., reward, 1.e6 * (monotonicTime() - start));
+	}
+	if (polishSolution(sol, POLISH_STEPS)) {
+		reportImprovement(engine, sol, iterationNumber, sol->error);
+		improved = true;
+	}
+	free(mark);
+	free(moved);
+	releaseBuffer(pool, saved);
+	freeCriticalSet(cs);
+	return improved;
+}
+
+// Same as optimize_critical(), polygons being picked uniformly: the move library alone.
+bool optimize_moves(Engine *engine, Solution *sol, int iterationNumber)
+{
+	return searchMoves(engine, sol, iterationNumber, false, "optimize_moves");
+}
@@ -0,0 +1,48 @@
+#ifndef MOVES_H
+#define MOVES_H
+
+#include <stdbool.h>
+#include "polygons.h"
+#include "params.h"
+
+struct Engine; // see engine.h, which includes this header
+
+typedef enum {MOVE_TRANSLATE, MOVE_PIVOT, MOVE_SWAP, MOVE_CLUSTER, MOVE_ROW, MOVE_DIRECTED, N_MOVES} MoveKind;
+
+// A move operator changes polygon 'idx' and possibly others, whose indices are written in 'moved'
+// (at most n_polygons of them, 'idx' included), after having been copied in 'saved' for backtracking.
+// Returns the number of moved polygons.
+typedef int (*MoveOperator)(rng_type *rng, const Parameters *params, Polygon *polArray, int n_polygons,
+	int idx, int *moved, Polygon *saved);
+
+typedef struct
+{
+	const char *name;
+	MoveOperator apply;
+	long tries, accepted, improvements;
+	double reward; // moving averages, per try
+	double time;   // in microseconds
+} MoveStats;
+
+// Registry of the operators with their yields. Operators are picked by a bandit, in proportion
+// to their average reward per microsecond, with some uniform exploration. The per polygon step
+// scales are kept along, so that they carry over from one search to the next on the same packing.
+typedef struct
+{
+	MoveStats stats[N_MOVES];
+	double *scales; // of the step size, per polygon, see adaptStepScale()
+	int n_scales;
+} MoveLibrary;
+
+void initMoveLibrary(MoveLibrary *lib);
+void clearMoveLibrary(MoveLibrary *lib);
+double* moveScales(MoveLibrary *lib, int n_polygons);
+MoveKind movePick(const MoveLibrary *lib, rng_type *rng);
+void moveReward(MoveLibrary *lib, MoveKind kind, bool accepted, bool improved, double reward, double time);
+void printMoveLibrary(const MoveLibrary *lib);
+void adaptStepScale(double *scale, bool accepted);
+bool movedCollide(const Polygon *polArray, int n_polygons, const int *moved, int n_moved, bool *mark);
+bool searchMoves(struct Engine *engine, Solution *sol, int iterationNumber, bool critical, const char *name);
+bool optimize_moves(struct Engine *engine, Solution *sol, int iterationNumber);
+
+#endif
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "nfp.h"
+
+static const double Pi = 3.14159265359;
+
+// One no-fit polygon per quantized relative angle, over the polygons period 2Pi/N_SIDES.
+// Only depends on N_SIDES: built once on first use, and read-only afterward.
+static NoFitPolygon Table[NFP_ANGLES];
+static pthread_once_t TableOnce = PTHREAD_ONCE_INIT;
+
+static double cross(const Point *O, const Point *A, const Point *B)
+{
+	return (A->x - O->x) * (B->y - O->y) - (A->y - O->y) * (B->x - O->x);
+}
+
+static int comparePoints(const void *a, const void *b)
+{
+	const Point *p = (const Point*) a, *q = (const Point*) b;
+	if (p->x != q->x)
+		return p->x < q->x ? -1 : 1;
+	return (p->y > q->y) - (p->y < q->y);
+}
+
+// Andrew's monotone chain. Returns the number of hull points, written counterclockwise in 'hull'
+// which must have room for 2 * length points. 'points' is sorted in place.
+static int convexHull(Point *points, int length, Point *hull)
+{
+	qsort(points, length, sizeof(Point), comparePoints);
+	int k = 0;
+	for (int i = 0; i < length; ++i) {
+		while (k >= 2 && cross(hull + k-2, hull + k-1, points + i) <= 0.)
+			--k;
+		hull[k++] = points[i];
+	}
+	for (int i = length-2, lower = k+1; i >= 0; --i) {
+		while (k >= lower && cross(hull + k-2, hull + k-1, points + i) <= 0.)
+			--k;
+		hull[k++] = points[i];
+	}
+	return k - 1; // the last point is the first one
+}
+
+// In the frame of the first polygon, whose vertex 0 is on the x axis. The second one is
+// rotated by 'delta' relative to it. Their Minkowski difference is the hull of the N_SIDES²
+// differences of vertices, having at most 2 * N_SIDES vertices.
+static void buildNoFitPolygon(double delta, NoFitPolygon *nfp)
+{
+	const double r = getRadius(), angle = 2. * Pi / N_SIDES;
+	Point differences[N_SIDES * N_SIDES], hull[2 * N_SIDES * N_SIDES];
+	for (int i = 0; i < N_SIDES; ++i) {
+		for (int j = 0; j < N_SIDES; ++j) {
+			differences[i * N_SIDES + j] = (Point) {
+				r * (cos(i * angle) - cos(j * angle + delta)),
+				r * (sin(i * angle) - sin(j * angle + delta))};
+		}
+	}
+	nfp->length = convexHull(differences, N_SIDES * N_SIDES, hull);
+	for (int e = 0; e < nfp->length; ++e) {
+		const Point *A = hull + e, *B = hull + (e+1) % nfp->length;
+		const double ex = B->x - A->x, ey = B->y - A->y, norm = sqrt(ex * ex + ey * ey);
+		nfp->points[e] = *A;
+		nfp->normals[e] = (Point) {ey / norm, -ex / norm};
+		nfp->offsets[e] = nfp->normals[e].x * A->x + nfp->normals[e].y * A->y;
+	}
+}
+
+static void buildTable(void)
+{
+	for (int k = 0; k < NFP_ANGLES; ++k)
+		buildNoFitPolygon(k * 2. * Pi / N_SIDES / NFP_ANGLES, Table + k);
+}
+
+// Signed depth of the centers offset inside the no-fit polygon of the nearest table angle: positive
+// when overlapping, and then the depth of the minimum translation vector. 'margin' is set to the
+// error bound due to the angle quantization: the actual depth is within 'margin' of the returned one
+// if positive, and below the returned one plus 'margin' if negative.
+double nfpClearance(const Polygon *pol1, const Polygon *pol2, double *margin)
+{
+	pthread_once(&TableOnce, buildTable);
+	const double period = 2. * Pi / N_SIDES, step = period / NFP_ANGLES, r = getRadius();
+
+	double delta = fmod(pol2->angle - pol1->angle, period);
+	if (delta < 0.)
+		delta += period;
+	const int k = (int) lround(delta / step);
+	const NoFitPolygon *nfp = Table + k % NFP_ANGLES;
+	// Vertices move by at most r * angle, and so does the no-fit polygon boundary:
+	*margin = r * fabs(delta - k * step) + EPSILON;
+
+	// Offset between the centers, in the frame of pol1:
+	const Point u = {(pol1->points[0].x - pol1->center.x) / r, (pol1->points[0].y - pol1->center.y) / r};
+	const double ox = pol2->center.x - pol1->center.x, oy = pol2->center.y - pol1->center.y;
+	const Point o = {u.x * ox + u.y * oy, u.x * oy - u.y * ox};
+
+	double depth = INFINITY;
+	for (int e = 0; e < nfp->length; ++e)
+		depth = fmin(depth, nfp->offsets[e] - nfp->normals[e].x * o.x - nfp->normals[e].y * o.y);
+	return depth;
+}
+
+// Same as intersects(), by table lookup. Falls back to it when the offset is too close
+// to the boundary of the no-fit polygon for the quantization error.
+bool nfpIntersects(const Polygon *pol1, const Polygon *pol2)
+{
+	if (distance2(&(pol1->center), &(pol2->center)) >= getDiam2())
+		return false;
+	double margin = 0.;
+	const double depth = nfpClearance(pol1, pol2, &margin);
+	if (depth > margin)
+		return true;
+	if (depth < -margin)
+		return false;
+	return intersects(pol1, pol2);
+}
@@ -0,0 +1,21 @@
+#ifndef NFP_H
+#define NFP_H
+
+#include <stdbool.h>
+#include "polygons.h"
+
+// No-fit polygon of two polygons at a given relative angle: the set of offsets between their
+// centers for which they overlap, i.e the Minkowski sum of the first and the reflected second.
+// Stored as the half-planes of its edges, 'offsets - normals.p' being positive inside.
+typedef struct
+{
+	Point points[2 * N_SIDES];
+	Point normals[2 * N_SIDES]; // outward, unit
+	double offsets[2 * N_SIDES];
+	int length;
+} NoFitPolygon;
+
+bool nfpIntersects(const Polygon *pol1, const Polygon *pol2);
+double nfpClearance(const Polygon *pol1, const Polygon *pol2, double *margin);
+
+#endif
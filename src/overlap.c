@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "overlap.h"
+
+static void pushContact(ContactList *row, int other, double area)
+{
+	if (row->length == row->capacity) {
+		row->capacity = row->capacity ? 2 * row->capacity : 8;
+		row->contacts = (Contact*) realloc(row->contacts, row->capacity * sizeof(Contact));
+	}
+	row->contacts[row->length++] = (Contact) {other, area};
+}
+
+static void removeContact(ContactList *row, int other)
+{
+	for (int k = 0; k < row->length; ++k) {
+		if (row->contacts[k].other == other) {
+			row->contacts[k] = row->contacts[--row->length];
+			return;
+		}
+	}
+}
+
+static void pushPending(OverlapCache *cache, int i, int j, double area)
+{
+	if (cache->n_pending == cache->pendingCapacity) {
+		cache->pendingCapacity = cache->pendingCapacity ? 2 * cache->pendingCapacity : 16;
+		cache->pending = (PendingPair*) realloc(cache->pending, cache->pendingCapacity * sizeof(PendingPair));
+	}
+	cache->pending[cache->n_pending++] = (PendingPair) {i, j, area};
+}
+
+// Same pairs as configurationQuality(), far away ones being skipped beforehand.
+double pairArea(const Polygon *pol1, const Polygon *pol2)
+{
+	if (distance2(&(pol1->center), &(pol2->center)) >= getDiam2())
+		return 0.;
+	return clippedArea(pol1, pol2);
+}
+
+OverlapCache* createOverlapCache(const Polygon *polArray, int n_polygons)
+{
+	OverlapCache *cache = (OverlapCache*) calloc(1, sizeof(OverlapCache));
+	cache->n_polygons = n_polygons;
+	cache->rows = (ContactList*) calloc(n_polygons, sizeof(ContactList));
+	cache->moved = (int*) calloc(n_polygons, sizeof(int));
+	cache->isMoved = (bool*) calloc(n_polygons, sizeof(bool));
+	cache->all = (int*) calloc(n_polygons, sizeof(int));
+	for (int i = 0; i < n_polygons; ++i)
+		cache->all[i] = i;
+#ifdef SWEEP_AND_PRUNE
+	cache->sap = createSweepAndPrune(polArray, n_polygons);
+#endif
+	overlapResync(cache, polArray);
+	return cache;
+}
+
+void freeOverlapCache(OverlapCache *cache)
+{
+	if (!cache)
+		return;
+	for (int i = 0; i < cache->n_polygons; ++i)
+		free(cache->rows[i].contacts);
+	free(cache->rows);
+	free(cache->moved);
+	free(cache->isMoved);
+	free(cache->all);
+	freeSweepAndPrune(cache->sap);
+	free(cache->pending);
+	free(cache);
+}
+
+static void addPair(OverlapCache *cache, const Polygon *polArray, int i, int j)
+{
+	const double area = pairArea(polArray + i, polArray + j);
+	if (area > 0.) {
+		pushContact(cache->rows + i, j, area);
+		pushContact(cache->rows + j, i, area);
+		cache->total += area;
+		++cache->n_pairs;
+	}
+}
+
+// Polygons which may overlap 'i', given the broad phase.
+static int candidates(OverlapCache *cache, int i, const int **others)
+{
+	if (!cache->sap) {
+		*others = cache->all;
+		return cache->n_polygons;
+	}
+	const int n_found = sapQuery(cache->sap, i, cache->sap->boxes + i);
+	*others = cache->sap->found;
+	return n_found;
+}
+
+// Recomputes everything from scratch, in O(n²) or O(n log(n)) with the broad phase.
+void overlapResync(OverlapCache *cache, const Polygon *polArray)
+{
+	const int n_polygons = cache->n_polygons;
+	for (int i = 0; i < n_polygons; ++i) {
+		cache->rows[i].length = 0;
+		cache->isMoved[i] = false;
+	}
+	cache->total = 0.;
+	cache->n_pairs = 0;
+	cache->n_moved = 0;
+	cache->n_pending = 0;
+	if (cache->sap) {
+		sapRebuild(cache->sap, polArray);
+		const int n_found = sapOverlaps(cache->sap);
+		for (int k = 0; k < n_found; ++k)
+			addPair(cache, polArray, cache->sap->found[2*k], cache->sap->found[2*k+1]);
+		return;
+	}
+	for (int i = 0; i < n_polygons; ++i) {
+		for (int j = i+1; j < n_polygons; ++j)
+			addPair(cache, polArray, i, j);
+	}
+}
+
+// Returns the total intersection area, given that only the 'moved' polygons have changed since
+// the last commit. Nothing is written in the cache rows until overlapCommit() is called, thus
+// a rejected move needs no cleanup. Duplicates in 'moved' are ignored.
+double overlapEvaluate(OverlapCache *cache, const Polygon *polArray, const int *moved, int n_moved)
+{
+	// The last evaluated polygons may have moved back, whether their move has been committed or not:
+	if (cache->sap)
+		sapUpdate(cache->sap, polArray, cache->moved, cache->n_moved);
+	for (int k = 0; k < cache->n_moved; ++k)
+		cache->isMoved[cache->moved[k]] = false;
+	cache->n_moved = 0;
+	cache->n_pending = 0;
+	for (int k = 0; k < n_moved; ++k) {
+		if (!cache->isMoved[moved[k]]) {
+			cache->isMoved[moved[k]] = true;
+			cache->moved[cache->n_moved++] = moved[k];
+		}
+	}
+	if (cache->sap)
+		sapUpdate(cache->sap, polArray, cache->moved, cache->n_moved);
+
+	// Pairs between two moved polygons are handled once, from the smallest index:
+	double removed = 0., added = 0.;
+	int removedPairs = 0;
+	for (int k = 0; k < cache->n_moved; ++k) {
+		const int i = cache->moved[k];
+		const ContactList *row = cache->rows + i;
+		for (int l = 0; l < row->length; ++l) {
+			const int j = row->contacts[l].other;
+			if (!cache->isMoved[j] || i < j) {
+				removed += row->contacts[l].area;
+				++removedPairs;
+			}
+		}
+		const int *others = NULL;
+		const int n_others = candidates(cache, i, &others);
+		for (int o = 0; o < n_others; ++o) {
+			const int j = others[o];
+			if (j == i || (cache->isMoved[j] && j < i))
+				continue;
+			const double area = pairArea(polArray + i, polArray + j);
+			if (area > 0.) {
+				pushPending(cache, i, j, area);
+				added += area;
+			}
+		}
+	}
+	// No rounding residue is left once all overlaps are gone:
+	cache->pendingPairs = cache->n_pairs - removedPairs + cache->n_pending;
+	cache->pendingTotal = cache->pendingPairs ? cache->total - removed + added : 0.;
+	return cache->pendingTotal;
+}
+
+// Applies the last evaluation.
+void overlapCommit(OverlapCache *cache)
+{
+	for (int k = 0; k < cache->n_moved; ++k) {
+		const int i = cache->moved[k];
+		ContactList *row = cache->rows + i;
+		for (int l = 0; l < row->length; ++l) {
+			const int j = row->contacts[l].other;
+			if (!cache->isMoved[j])
+				removeContact(cache->rows + j, i);
+		}
+		row->length = 0;
+	}
+	for (int k = 0; k < cache->n_pending; ++k) {
+		const PendingPair *p = cache->pending + k;
+		pushContact(cache->rows + p->i, p->j, p->area);
+		pushContact(cache->rows + p->j, p->i, p->area);
+	}
+	cache->total = cache->pendingTotal;
+	cache->n_pairs = cache->pendingPairs;
+	cache->n_pending = 0;
+}
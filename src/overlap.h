@@ -0,0 +1,56 @@
+#ifndef OVERLAP_H
+#define OVERLAP_H
+
+#include <stdbool.h>
+#include "polygons.h"
+#include "sap.h"
+
+// Sparse cache of the pairwise intersection areas of a configuration: each polygon
+// keeps the list of its contacts with a non-zero area, along with their running total.
+// Moving some polygons only requires to recompute the rows of the moved ones.
+
+typedef struct
+{
+	int other;
+	double area;
+} Contact;
+
+typedef struct
+{
+	Contact *contacts;
+	int length, capacity;
+} ContactList;
+
+typedef struct
+{
+	int i, j;
+	double area;
+} PendingPair;
+
+typedef struct
+{
+	int n_polygons;
+	ContactList *rows;
+	double total; // same as configurationQuality(), short of rounding errors.
+	int n_pairs;  // when 0, 'total' is exactly 0.
+	SweepAndPrune *sap; // broad phase, NULL when all pairs are tested
+	int *all;           // 0, 1, ..., n_polygons-1
+
+	// Last evaluation, not committed yet:
+	int *moved;
+	int n_moved;
+	bool *isMoved;
+	PendingPair *pending;
+	int n_pending, pendingCapacity;
+	double pendingTotal;
+	int pendingPairs;
+} OverlapCache;
+
+double pairArea(const Polygon *pol1, const Polygon *pol2);
+OverlapCache* createOverlapCache(const Polygon *polArray, int n_polygons);
+void freeOverlapCache(OverlapCache *cache);
+void overlapResync(OverlapCache *cache, const Polygon *polArray);
+double overlapEvaluate(OverlapCache *cache, const Polygon *polArray, const int *moved, int n_moved);
+void overlapCommit(OverlapCache *cache);
+
+#endif
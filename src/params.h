@@ -0,0 +1,26 @@
+#ifndef PARAMS_H
+#define PARAMS_H
+
+// Engines run by runOptimizer(), see search.h.
+typedef enum {OPTIMIZER_GREEDY, OPTIMIZER_NEIGHBOURHOOD, OPTIMIZER_ANNEALING, OPTIMIZER_MOVES, N_OPTIMIZERS} Optimizer;
+
+// Search parameters, owned by each engine. Defaults are taken from settings.h,
+// and may be replaced by tuned ones, see tune.h.
+typedef struct
+{
+	double stepSize;
+	double rotationProba;
+	int neighbourhood;  // candidate buffers of optimize_2()
+	double epsilon;     // penalty below which a configuration is deemed feasible
+	double temperature; // initial inverse temperature of optimize_sa()
+	double cooling;     // factor of the inverse temperature every 1024 iterations
+	Optimizer optimizer;
+} Parameters;
+
+// Success counts of the current window, see growOnSuccess().
+typedef struct
+{
+	int trials, successes;
+} SuccessWindow;
+
+#endif
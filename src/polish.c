@@ -0,0 +1,223 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "polish.h"
+#include "lp.h"
+
+// LP variables, each one split in its positive and negative parts: dx, dy and dtheta of each
+// polygon, then the moves of the container lower left corner and of its side.
+enum {DX, DY, DTHETA, POSE_VARS};
+
+static int poseVar(int i, int k)
+{
+	return 2 * (POSE_VARS * i + k);
+}
+
+static void addTerm(double *row, int var, double coefficient)
+{
+	row[var] += coefficient;
+	row[var+1] -= coefficient;
+}
+
+// Upper bound of 'coefficient * |var|'.
+static void addAbs(double *row, int var, double coefficient)
+{
+	row[var] += coefficient;
+	row[var+1] += coefficient;
+}
+
+// Smallest signed distance of the vertices of 'other' beyond edge 'e' of 'pol'.
+static double edgeSeparation(const Polygon *pol, int e, const Polygon *other, Point *normal)
+{
+	const Point *A = pol->points + e, *B = pol->points + (e+1) % N_SIDES;
+	const double ex = B->x - A->x, ey = B->y - A->y, norm = sqrt(ex * ex + ey * ey);
+	*normal = (Point) {ey / norm, -ex / norm};
+	double sep = INFINITY;
+	for (int k = 0; k < N_SIDES; ++k)
+		sep = fmin(sep, normal->x * (other->points[k].x - A->x) + normal->y * (other->points[k].y - A->y));
+	return sep;
+}
+
+// The pair is kept apart by the edge line of largest separation: each vertex of the other polygon
+// close to it must stay beyond it, by at least POLISH_GAP. Linearized in both poses, the rotations being penalized by
+// 'K * |dtheta|', an upper bound of the neglected terms within the trust region.
+static void addContactRows(LinearProgram *lp, const Polygon *polArray, int i, int j, double band, double K)
+{
+	int a = i, b = j, edge = 0;
+	double best = -INFINITY;
+	for (int e = 0; e < 2 * N_SIDES; ++e) {
+		Point n;
+		const double sep = e < N_SIDES ? edgeSeparation(polArray + i, e, polArray + j, &n)
+			: edgeSeparation(polArray + j, e - N_SIDES, polArray + i, &n);
+		if (sep > best) {
+			best = sep;
+			edge = e;
+		}
+	}
+	if (best >= band)
+		return;
+	if (edge >= N_SIDES) {
+		a = j;
+		b = i;
+		edge -= N_SIDES;
+	}
+	const Polygon *pa = polArray + a, *pb = polArray + b;
+	const Point *A = pa->points + edge;
+	Point n;
+	edgeSeparation(pa, edge, pb, &n);
+
+	for (int k = 0; k < N_SIDES; ++k) {
+		const Point *w = pb->points + k;
+		const double g = n.x * (w->x - A->x) + n.y * (w->y - A->y);
+		if (g >= band)
+			continue;
+		double *row = lpAddRow(lp, fmax(g - POLISH_GAP, 0.)); // -dg <= g - gap
+		addTerm(row, poseVar(b, DX), -n.x);
+		addTerm(row, poseVar(b, DY), -n.y);
+		addTerm(row, poseVar(a, DX), n.x);
+		addTerm(row, poseVar(a, DY), n.y);
+		addTerm(row, poseVar(b, DTHETA), -(n.y * (w->x - pb->center.x) - n.x * (w->y - pb->center.y)));
+		addTerm(row, poseVar(a, DTHETA), -(n.x * (w->y - pa->center.y) - n.y * (w->x - pa->center.x)));
+		addAbs(row, poseVar(a, DTHETA), K);
+		addAbs(row, poseVar(b, DTHETA), K);
+	}
+}
+
+// Separation of the pair along the edge normal of largest separation, a lower bound of their distance.
+static double pairSeparation(const Polygon *pol1, const Polygon *pol2)
+{
+	double best = -INFINITY;
+	for (int e = 0; e < 2 * N_SIDES; ++e) {
+		Point n;
+		best = fmax(best, e < N_SIDES ? edgeSeparation(pol1, e, pol2, &n) : edgeSeparation(pol2, e - N_SIDES, pol1, &n));
+	}
+	return best;
+}
+
+// Smallest separation of the pairs of close polygons, INFINITY if there is none.
+static double minSeparation(const Polygon *polArray, int n_polygons)
+{
+	double sep = INFINITY;
+	for (int i = 0; i < n_polygons; ++i) {
+		for (int j = i+1; j < n_polygons; ++j) {
+			if (distance2(&(polArray[i].center), &(polArray[j].center)) < getDiam2())
+				sep = fmin(sep, pairSeparation(polArray + i, polArray + j));
+		}
+	}
+	return sep;
+}
+
+// Vertices close to the container sides must stay inside it.
+static void addContainerRows(LinearProgram *lp, const Polygon *pol, int i, const Box *container, double band, double K)
+{
+	const int n_polygons = (lp->n_vars - 6) / (2 * POSE_VARS);
+	const int cornerX = 2 * POSE_VARS * n_polygons, cornerY = cornerX + 2, side = cornerX + 4;
+	for (int k = 0; k < N_SIDES; ++k) {
+		const Point *v = pol->points + k;
+		const double rx = -(v->y - pol->center.y), ry = v->x - pol->center.x; // rotation derivative
+		for (int axis = 0; axis < 2; ++axis) {
+			const double p = axis ? v->y : v->x, r = axis ? ry : rx;
+			const double low = axis ? container->ymin : container->xmin, high = axis ? container->ymax : container->xmax;
+			const int move = axis ? poseVar(i, DY) : poseVar(i, DX), corner = axis ? cornerY : cornerX;
+			if (p - low < band) {
+				double *row = lpAddRow(lp, p - low);
+				addTerm(row, corner, 1.);
+				addTerm(row, move, -1.);
+				addTerm(row, poseVar(i, DTHETA), -r);
+				addAbs(row, poseVar(i, DTHETA), K);
+			}
+			if (high - p < band) {
+				double *row = lpAddRow(lp, high - p);
+				addTerm(row, move, 1.);
+				addTerm(row, poseVar(i, DTHETA), r);
+				addAbs(row, poseVar(i, DTHETA), K);
+				addTerm(row, corner, -1.);
+				addTerm(row, side, -1.);
+			}
+		}
+	}
+}
+
+// Minimizes the container side over simultaneous small moves of all polygons: the contacts, and the
+// vertices close to the container, are linearized around the current poses within a trust region.
+// Each LP step is checked exactly, the trust region being halved on failure and doubled on success.
+// The contacts keep the pairs POLISH_GAP apart, and steps leaving touching pairs are rejected, for
+// those pass checkConfiguration() but are degenerate cases of intersectionArea().
+// The configuration must be valid, and stays so. Returns true if its side has been reduced.
+bool polish(Polygon *polArray, int n_polygons, int steps)
+{
+	if (n_polygons > POLISH_MAX_POLYGONS || !checkConfiguration(polArray, n_polygons))
+		return false;
+	const int n_vars = 2 * POSE_VARS * n_polygons + 6;
+	const int cornerX = 2 * POSE_VARS * n_polygons, cornerY = cornerX + 2, sideVar = cornerX + 4;
+	const double r = getRadius(), diameter = sqrt(getDiam2());
+	LinearProgram *lp = createLinearProgram(n_vars);
+	double *x = (double*) calloc(n_vars, sizeof(double));
+	Polygon *saved = (Polygon*) calloc(n_polygons, sizeof(Polygon));
+	double trust = POLISH_TRUST;
+	bool improved = false;
+
+	for (int step = 0; step < steps && trust > POLISH_MIN_TRUST; ++step) {
+		const Box b = findBoundary(polArray, n_polygons);
+		const double side = fmax(b.xmax - b.xmin, b.ymax - b.ymin);
+		const Box container = {b.xmin, b.xmin + side, b.ymin, b.ymin + side};
+
+		// Within the trust region, vertices and container sides move by less than 4 * trust,
+		// and a separation by less than 12 * trust, see the bounds in addContactRows().
+		lpClear(lp);
+		for (int i = 0; i < n_polygons; ++i) {
+			addAbs(lpAddRow(lp, trust), poseVar(i, DX), 1.);
+			addAbs(lpAddRow(lp, trust), poseVar(i, DY), 1.);
+			addAbs(lpAddRow(lp, trust / r), poseVar(i, DTHETA), 1.);
+			addContainerRows(lp, polArray + i, i, &container, 6. * trust, trust);
+		}
+		addAbs(lpAddRow(lp, trust), cornerX, 1.);
+		addAbs(lpAddRow(lp, trust), cornerY, 1.);
+		addAbs(lpAddRow(lp, trust), sideVar, 1.);
+		for (int i = 0; i < n_polygons; ++i) {
+			for (int j = i+1; j < n_polygons; ++j) {
+				const double reach = diameter + 16. * trust;
+				if (distance2(&(polArray[i].center), &(polArray[j].center)) < reach * reach)
+					addContactRows(lp, polArray, i, j, 16. * trust, 6. * trust);
+			}
+		}
+		lpSetObjective(lp, sideVar, -1.);
+		lpSetObjective(lp, sideVar + 1, 1.);
+		lpSolve(lp, POLISH_PIVOTS, x);
+
+		const double gain = x[sideVar + 1] - x[sideVar];
+		if (gain <= POLISH_TOL * side) {
+			trust /= 4.; // the rotations penalty may be too strong
+			continue;
+		}
+		memcpy(saved, polArray, n_polygons * sizeof(Polygon));
+		for (int i = 0; i < n_polygons; ++i) {
+			const int v = poseVar(i, 0);
+			rotation(polArray + i, x[v + 2 * DTHETA] - x[v + 2 * DTHETA + 1]);
+			translation(polArray + i, x[v + 2 * DX] - x[v + 2 * DX + 1], x[v + 2 * DY] - x[v + 2 * DY + 1]);
+		}
+		if (findBigPolygonSize(polArray, n_polygons) < side && minSeparation(polArray, n_polygons) > 0.
+			&& checkConfiguration(polArray, n_polygons)) {
+			improved = true;
+			trust = fmin(2. * trust, POLISH_TRUST);
+		}
+		else {
+			memcpy(polArray, saved, n_polygons * sizeof(Polygon));
+			trust /= 2.;
+		}
+	}
+	free(saved);
+	free(x);
+	freeLinearProgram(lp);
+	return improved;
+}
+
+// Same as polish(), also updating the side and error of 'sol'.
+bool polishSolution(Solution *sol, int steps)
+{
+	if (!polish(sol->polArray, sol->n_polygons, steps))
+		return false;
+	findErrorRatio(sol->polArray, sol->n_polygons, &sol->bigSquareSide, &sol->error);
+	return true;
+}
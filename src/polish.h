@@ -0,0 +1,10 @@
+#ifndef POLISH_H
+#define POLISH_H
+
+#include <stdbool.h>
+#include "polygons.h"
+
+bool polish(Polygon *polArray, int n_polygons, int steps);
+bool polishSolution(Solution *sol, int steps);
+
+#endif
@@ -3,23 +3,44 @@
 #include <math.h>
 #include <assert.h>
 #include "polygons.h"
+#include "nfp.h"
+
+#if N_SIDES < 3
+#error "N_SIDES must be at least 3."
+#endif
 
 static const double Pi = 3.14159265359;
 static const double N_angle = 2. * Pi / N_SIDES;
-static double Diam2 = 0.;
-static double Radius = 0.;
 
-// To be called at the program's start.
-void initConstExpr(void)
+// Those only depend on N_SIDES, and are folded into constants by the compiler.
+// Nothing is written at runtime, so they are safe to use from any thread.
+
+// Squared diameter.
+static inline double diam2(void)
+{
+	return 8. / (N_SIDES * sin(N_angle));
+}
+
+// Chosen so that the area is 1 for all N_SIDES.
+static inline double radius(void)
 {
-	assert(N_SIDES > 2);
-	Diam2 = 8. / (N_SIDES * sin(N_angle)); // squared diameter.
-	Radius = sqrt(Diam2) / 2.; // chosen so that the area is 1 for all N_SIDES.
+	return sqrt(diam2()) / 2.;
+}
+
+// Radius of the inscribed circle.
+static inline double inradius(void)
+{
+	return radius() * cos(Pi / N_SIDES);
 }
 
 double getRadius(void)
 {
-	return Radius;
+	return radius();
+}
+
+double getDiam2(void)
+{
+	return diam2();
 }
 
 // Generate a polygon of area equal to 1.
@@ -27,9 +48,10 @@ Polygon createPolygon(double xCenter, double yCenter)
 {
 	Polygon pol = {0};
 	pol.center = (Point) {xCenter, yCenter};
+	const double r = radius();
 	for (int i = 0; i < N_SIDES; ++i) {
 		const double angle = (i + 0.5) * N_angle;
-		pol.points[i] = (Point) {xCenter + Radius * cos(angle), yCenter + Radius * sin(angle)};
+		pol.points[i] = (Point) {xCenter + r * cos(angle), yCenter + r * sin(angle)};
 	}
 	return pol;
 }
@@ -58,18 +80,21 @@ void rotation(Polygon *pol, double angle)
 	for (int i = 0; i < N_SIDES; ++i) {
 		pol->points[i] = rotatePoint(pol->center, pol->points[i], co, si);
 	} // No need to update the center for this one.
+	pol->angle += angle;
 }
 
 // Question: is it faster to apply the mutation on the AB segment,
 // and then regenerate the polygon with createPolygon? This would require
 // disabling the assert if said function, and save 'direc' in the struct.
-void mutation(rng_type *rng, Polygon *pol)
+void mutation(rng_type *rng, const Parameters *params, Polygon *pol)
 {
-	const float proba = rng_real(rng);
+	float u[3]; // all uniforms needed by a mutation, drawn in one call.
+	rng_fill(rng, u, 3);
+	const float proba = u[0];
 
-	if (proba < ROTATION_PROBA) {
-		const double angle = proba - ROTATION_PROBA/2.;
-		rotation(pol, angle); // angle between -ROTATION_PROBA/2. and ROTATION_PROBA/2.
+	if (proba < params->rotationProba) {
+		const double angle = proba - params->rotationProba/2.;
+		rotation(pol, angle); // angle between -rotationProba/2. and rotationProba/2.
 	}
 
 	// if (proba < ROTATION_PROBA) {
@@ -77,9 +102,25 @@ void mutation(rng_type *rng, Polygon *pol)
 	// 	rotation(pol, angle);
 	// }
 
-	// TODO: try rotating around the corners too?
+	// Rotations around the corners, and other moves: see moves.h.
 
-	translation(pol, STEP_SIZE * rng_real(rng), STEP_SIZE * rng_real(rng));
+	translation(pol, params->stepSize * u[1], params->stepSize * u[2]);
+}
+
+// Same as mutation(), but translating in any direction. Needed when the
+// container is fixed, for the polygons would else drift to one corner.
+void signedMutation(rng_type *rng, const Parameters *params, Polygon *pol)
+{
+	float u[3];
+	rng_fill(rng, u, 3);
+	const float proba = u[0];
+
+	if (proba < params->rotationProba) {
+		const double angle = proba - params->rotationProba/2.;
+		rotation(pol, angle);
+	}
+
+	translation(pol, params->stepSize * (2.f * u[1] - 1.f), params->stepSize * (2.f * u[2] - 1.f));
 }
 
 Box findBoundary(const Polygon *polArray, int n_polygons)
@@ -121,7 +162,11 @@ bool checkConfiguration(const Polygon *polArray, int n_polygons)
 {
 	for (int i = 0; i < n_polygons; ++i) {
 		for (int j = i+1; j < n_polygons; ++j) {
+#ifdef NO_FIT_POLYGONS
+			if (nfpIntersects(polArray + i, polArray + j))
+#else
 			if (intersects(polArray + i, polArray + j))
+#endif
 				return false;
 		}
 	}
@@ -131,8 +176,17 @@ bool checkConfiguration(const Polygon *polArray, int n_polygons)
 // Returns true when the polygons intersection has non-zero area.
 bool intersects(const Polygon *pol1, const Polygon *pol2)
 {
-	// Huge optimization to not consider far away polygons.
-	if (distance2(&(pol1->center), &(pol2->center)) >= Diam2)
+	// Cheapest tests first. Huge optimization to not consider far away polygons:
+	const double d2 = distance2(&(pol1->center), &(pol2->center));
+	if (d2 >= diam2())
+		return false;
+
+	// Overlapping inscribed circles:
+	if (d2 < 4. * inradius() * inradius())
+		return true;
+
+	const Box b1 = findBoundary(pol1, 1), b2 = findBoundary(pol2, 1);
+	if (b1.xmax < b2.xmin || b2.xmax < b1.xmin || b1.ymax < b2.ymin || b2.ymax < b1.ymin)
 		return false;
 
 	Segment segments1[N_SIDES] = {0};
@@ -153,16 +207,101 @@ bool intersects(const Polygon *pol1, const Polygon *pol2)
 	return false;
 }
 
+// Separating axis test: returns true if the polygons overlap, in which case 'axis' is the unit vector
+// along which pol2 must be translated by 'depth' to separate them, i.e the minimum translation vector.
+bool penetration(const Polygon *pol1, const Polygon *pol2, Point *axis, double *depth)
+{
+	if (distance2(&(pol1->center), &(pol2->center)) >= diam2())
+		return false;
+	*depth = INFINITY;
+	for (int k = 0; k < 2 * N_SIDES; ++k) {
+		const Polygon *pol = k < N_SIDES ? pol1 : pol2;
+		const Point *A = pol->points + k % N_SIDES, *B = pol->points + (k+1) % N_SIDES;
+		const double ex = B->x - A->x, ey = B->y - A->y, norm = sqrt(ex * ex + ey * ey);
+		const Point normal = {ey / norm, -ex / norm};
+		double min1 = INFINITY, max1 = -INFINITY, min2 = INFINITY, max2 = -INFINITY;
+		for (int i = 0; i < N_SIDES; ++i) {
+			const double p1 = normal.x * pol1->points[i].x + normal.y * pol1->points[i].y;
+			const double p2 = normal.x * pol2->points[i].x + normal.y * pol2->points[i].y;
+			min1 = fmin(min1, p1); max1 = fmax(max1, p1);
+			min2 = fmin(min2, p2); max2 = fmax(max2, p2);
+		}
+		// Pushing pol2 forward or backward along the normal:
+		const double forward = max1 - min2, backward = max2 - min1;
+		if (forward <= 0. || backward <= 0.)
+			return false; // separating axis
+		if (fmin(forward, backward) < *depth) {
+			*depth = fmin(forward, backward);
+			*axis = forward < backward ? normal : (Point) {-normal.x, -normal.y};
+		}
+	}
+	return true;
+}
+
+// Pushes overlapping pairs apart along their minimum translation vectors, each polygon of a pair
+// moving by half the depth. Returns true if the configuration is valid after at most 'rounds' rounds.
+bool repairOverlaps(Polygon *polArray, int n_polygons, int rounds)
+{
+	for (int round = 0; round < rounds; ++round) {
+		bool overlap = false;
+		for (int i = 0; i < n_polygons; ++i) {
+			for (int j = i+1; j < n_polygons; ++j) {
+				Point axis = {0};
+				double depth = 0.;
+				if (penetration(polArray + i, polArray + j, &axis, &depth)) {
+					const double push = (depth + EPSILON) / 2.;
+					translation(polArray + i, -push * axis.x, -push * axis.y);
+					translation(polArray + j, push * axis.x, push * axis.y);
+					overlap = true;
+				}
+			}
+		}
+		if (!overlap)
+			break;
+	}
+	return checkConfiguration(polArray, n_polygons);
+}
+
+// Same as intersectionArea(), by convex clipping: touching polygons are no special case.
+double clippedArea(const Polygon *pol1, const Polygon *pol2)
+{
+	Point inter[2*N_SIDES];
+	const int count = clipPolygon(pol1->points, N_SIDES, pol2->points, N_SIDES, inter);
+	return count < 3 ? 0. : fmax(polygonArea(inter, count), 0.);
+}
+
 // The lower the score, the higher the quality.
-// The score actually is an upper bound of the total intersection area,
-// indeed some pairwise intersection area may be counted more than once.
+// The score is the sum of the exact intersection areas of all pairs, see clippedArea(),
+// and is 0 if and only if no pair overlaps.
 double configurationQuality(const Polygon *polArray, int n_polygons)
 {
 	double score = 0.;
 	for (int i = 0; i < n_polygons; ++i) {
 		for (int j = i+1; j < n_polygons; ++j) {
-			score += intersectionArea(polArray + i, polArray + j);
+			score += clippedArea(polArray + i, polArray + j);
 		}
 	}
 	return score;
 }
+
+// Corners in counterclockwise order.
+void boxCorners(const Box *box, Point corners[4])
+{
+	corners[0] = (Point) {box->xmin, box->ymin};
+	corners[1] = (Point) {box->xmax, box->ymin};
+	corners[2] = (Point) {box->xmax, box->ymax};
+	corners[3] = (Point) {box->xmin, box->ymax};
+}
+
+// Area of the polygon lying outside of the container.
+double protrusionArea(const Polygon *pol, const Box *container)
+{
+	const double r = radius();
+	if (pol->center.x - r >= container->xmin && pol->center.x + r <= container->xmax &&
+		pol->center.y - r >= container->ymin && pol->center.y + r <= container->ymax)
+		return 0.;
+	Point corners[4], inside[N_SIDES + 4];
+	boxCorners(container, corners);
+	const int count = clipPolygon(pol->points, N_SIDES, corners, 4, inside);
+	return fmax(polygonArea(pol->points, N_SIDES) - polygonArea(inside, count), 0.);
+}
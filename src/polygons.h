@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "settings.h"
+#include "params.h"
 #include "geom_tools.h"
 
 // typedef enum {POS = 1, NEG = -1} Direction;
@@ -20,19 +21,25 @@ typedef struct
 	double error;
 } Solution;
 
-void initConstExpr(void);
 double getRadius(void);
+double getDiam2(void);
 Polygon createPolygon(double xCenter, double yCenter);
 void printPolygon(const Polygon *s);
 void translation(Polygon *s, double xDelta, double yDelta);
 void rotation(Polygon *s, double angle);
-void mutation(rng_type *rng, Polygon *s);
+void mutation(rng_type *rng, const Parameters *params, Polygon *s);
+void signedMutation(rng_type *rng, const Parameters *params, Polygon *s);
 Box findBoundary(const Polygon *polArray, int n_polygons);
 double findBigPolygonSize(const Polygon *polArray, int n_polygons);
 void findErrorRatio(const Polygon *polArray, int n_polygons, double *side, double *error);
 double relative_error(double ref, double x);
 bool checkConfiguration(const Polygon *polArray, int n_polygons);
 bool intersects(const Polygon *pol1, const Polygon *pol2);
+bool penetration(const Polygon *pol1, const Polygon *pol2, Point *axis, double *depth);
+bool repairOverlaps(Polygon *polArray, int n_polygons, int rounds);
+double clippedArea(const Polygon *pol1, const Polygon *pol2);
 double configurationQuality(const Polygon *polArray, int n_polygons);
+void boxCorners(const Box *box, Point corners[4]);
+double protrusionArea(const Polygon *pol, const Box *container);
 
 #endif
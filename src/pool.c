@@ -0,0 +1,73 @@
+#define _POSIX_C_SOURCE 200112L // for posix_memalign()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pool.h"
+
+BufferPool* createBufferPool(int n_polygons)
+{
+	BufferPool *pool = (BufferPool*) calloc(1, sizeof(BufferPool));
+	pool->n_polygons = n_polygons;
+	const size_t bytes = n_polygons * sizeof(Polygon);
+	pool->stride = (bytes + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE;
+	if (pool->stride < sizeof(void*))
+		pool->stride = CACHE_LINE;
+	return pool;
+}
+
+void freeBufferPool(BufferPool *pool)
+{
+	if (!pool)
+		return;
+	if (pool->n_acquired)
+		printf("Warning: %d buffers still acquired when freeing the pool.\n", pool->n_acquired);
+	for (int c = 0; c < pool->n_chunks; ++c)
+		free(pool->chunks[c]);
+	free(pool->chunks);
+	free(pool);
+}
+
+// Only called when the free list is empty.
+static void growPool(BufferPool *pool)
+{
+	void *chunk = NULL;
+	if (posix_memalign(&chunk, CACHE_LINE, POOL_CHUNK * pool->stride)) {
+		printf("Cannot allocate a chunk of %d buffers.\n", POOL_CHUNK);
+		exit(1);
+	}
+	pool->chunks = (void**) realloc(pool->chunks, (pool->n_chunks + 1) * sizeof(void*));
+	pool->chunks[pool->n_chunks++] = chunk;
+	for (int k = POOL_CHUNK - 1; k >= 0; --k) {
+		void **buffer = (void**) ((char*) chunk + k * pool->stride);
+		*buffer = pool->freeList;
+		pool->freeList = buffer;
+	}
+}
+
+// The content of the returned buffer is undefined.
+Polygon* acquireBuffer(BufferPool *pool)
+{
+	if (!pool->freeList)
+		growPool(pool);
+	void **buffer = (void**) pool->freeList;
+	pool->freeList = *buffer;
+	++pool->n_acquired;
+	return (Polygon*) buffer;
+}
+
+Polygon* acquireCopy(BufferPool *pool, const Polygon *polArray)
+{
+	Polygon *buffer = acquireBuffer(pool);
+	memcpy(buffer, polArray, pool->n_polygons * sizeof(Polygon));
+	return buffer;
+}
+
+void releaseBuffer(BufferPool *pool, Polygon *buffer)
+{
+	if (!buffer)
+		return;
+	*(void**) buffer = pool->freeList;
+	pool->freeList = buffer;
+	--pool->n_acquired;
+}
@@ -0,0 +1,27 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include "settings.h"
+#include "geom_tools.h"
+
+// Pool of configuration buffers of 'n_polygons' polygons each, aligned on cache lines.
+// Buffers are carved out of chunks of POOL_CHUNK buffers, and recycled through a free list:
+// acquiring and releasing are O(1), and once warmed up the pool allocates nothing.
+// Not thread-safe: each thread or engine uses its own pool.
+typedef struct
+{
+	int n_polygons;
+	size_t stride;   // bytes per buffer, a multiple of CACHE_LINE
+	void **chunks;
+	int n_chunks;
+	void *freeList;  // the first bytes of a free buffer point to the next one
+	int n_acquired;
+} BufferPool;
+
+BufferPool* createBufferPool(int n_polygons);
+void freeBufferPool(BufferPool *pool);
+Polygon* acquireBuffer(BufferPool *pool);
+Polygon* acquireCopy(BufferPool *pool, const Polygon *polArray);
+void releaseBuffer(BufferPool *pool, Polygon *buffer);
+
+#endif
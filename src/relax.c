@@ -0,0 +1,206 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include "relax.h"
+#include "search.h"
+
+// Relaxation engine: the energy is the sum of squared pairwise overlap areas, plus the sum of
+// squared areas protruding from a square container, plus 'pressure' times the container side.
+// Every term has an analytic gradient, which is descended with FIRE (Bitzek et al., 2006).
+//
+// Degrees of freedom, in this order: (x, y, radius * angle) for each polygon, then the container
+// side. Angles are scaled by the radius, so that all coordinates move vertices alike.
+
+// FIRE constants:
+#define FIRE_N_MIN    (5)
+#define FIRE_F_INC    (1.1)
+#define FIRE_F_DEC    (0.5)
+#define FIRE_ALPHA    (0.1)
+#define FIRE_F_ALPHA  (0.99)
+
+static Box squareBox(Point center, double side)
+{
+	return (Box) {center.x - side/2., center.x + side/2., center.y - side/2., center.y + side/2.};
+}
+
+// The derivative of area(pol ∩ other) with respect to a motion of 'pol', is the integral
+// over the part of pol's boundary inside 'other', of the normal speed of said boundary.
+// Adds 'factor' times this derivative to 'grad' (x, y, radius * angle).
+static void areaGradient(const Polygon *pol, const Point *otherPoints, int otherLength, double factor, double grad[3])
+{
+	const Point c = pol->center;
+	for (int k = 0; k < N_SIDES; ++k) {
+		const Point *A = pol->points + k, *B = pol->points + (k+1) % N_SIDES;
+		Point start = {0}, end = {0};
+		if (!clipSegment(A, B, otherPoints, otherLength, &start, &end))
+			continue;
+		const double len = distance(&start, &end);
+		const double edgeLen = distance(A, B);
+		Point normal = {(B->y - A->y) / edgeLen, (A->x - B->x) / edgeLen};
+		if ((A->x - c.x) * normal.x + (A->y - c.y) * normal.y < 0.) { // must point outward
+			normal.x = -normal.x;
+			normal.y = -normal.y;
+		}
+		// The rotation speed is linear along the edge, thus its integral is given at the middle:
+		const Point m = {(start.x + end.x) / 2. - c.x, (start.y + end.y) / 2. - c.y};
+		grad[0] += factor * len * normal.x;
+		grad[1] += factor * len * normal.y;
+		grad[2] += factor * len * (m.x * normal.y - m.y * normal.x) / getRadius();
+	}
+}
+
+// Total length of the container boundary lying inside the polygon.
+static double boundaryInside(const Point corners[4], const Polygon *pol)
+{
+	double total = 0.;
+	for (int k = 0; k < 4; ++k) {
+		Point start = {0}, end = {0};
+		if (clipSegment(corners + k, corners + (k+1) % 4, pol->points, N_SIDES, &start, &end))
+			total += distance(&start, &end);
+	}
+	return total;
+}
+
+// Returns the energy of the configuration, and fills its gradient 'grad' of size 3 * n_polygons + 1.
+double relaxEnergy(const Polygon *polArray, int n_polygons, const Box *container, double pressure, double *grad)
+{
+	const double diam2 = getDiam2();
+	memset(grad, 0, (3 * n_polygons + 1) * sizeof(double));
+	double energy = pressure * (container->xmax - container->xmin);
+	grad[3 * n_polygons] = pressure;
+
+	for (int i = 0; i < n_polygons; ++i) {
+		for (int j = i+1; j < n_polygons; ++j) {
+			if (distance2(&(polArray[i].center), &(polArray[j].center)) >= diam2)
+				continue;
+			Point inter[2*N_SIDES];
+			const int count = clipPolygon(polArray[i].points, N_SIDES, polArray[j].points, N_SIDES, inter);
+			const double area = count < 3 ? 0. : polygonArea(inter, count);
+			if (area <= 0.)
+				continue;
+			energy += area * area;
+			areaGradient(polArray + i, polArray[j].points, N_SIDES, 2. * area, grad + 3*i);
+			areaGradient(polArray + j, polArray[i].points, N_SIDES, 2. * area, grad + 3*j);
+		}
+	}
+
+	// The container sides move outward at half the speed of its side length:
+	Point corners[4];
+	boxCorners(container, corners);
+	for (int i = 0; i < n_polygons; ++i) {
+		const double outside = protrusionArea(polArray + i, container);
+		if (outside <= 0.)
+			continue;
+		energy += outside * outside;
+		areaGradient(polArray + i, corners, 4, -2. * outside, grad + 3*i);
+		grad[3 * n_polygons] -= outside * boundaryInside(corners, polArray + i);
+	}
+	return energy;
+}
+
+// Scales the centers away from 'center' until no overlap is left. Returns false on failure.
+static bool inflate(Polygon *polArray, int n_polygons, Point center)
+{
+	double previous = 1.;
+	for (double factor = 1. + 1.e-12; factor < 1.1; factor = 1. + 2. * (factor - 1.)) {
+		if (checkConfiguration(polArray, n_polygons))
+			return true;
+		const double ratio = factor / previous - 1.;
+		for (int i = 0; i < n_polygons; ++i)
+			translation(polArray + i, ratio * (polArray[i].center.x - center.x), ratio * (polArray[i].center.y - center.y));
+		previous = factor;
+	}
+	return checkConfiguration(polArray, n_polygons);
+}
+
+// Compresses the current solution into a locally jammed packing. The pressure is divided by 4 at
+// each stage, the last stage having none, so that the remaining overlaps are relaxed away.
+// At the deadline, the current configuration is still inflated to be checked.
+// Returns true if the solution has been improved.
+bool optimize_relax(Engine *engine, Solution *sol, int iterationNumber)
+{
+	const int n_polygons = sol->n_polygons, dof = 3 * n_polygons + 1;
+	Polygon *polArray = sol->polArray;
+	BufferPool *pool = enginePool(engine, n_polygons);
+	Polygon *best_polArray = acquireCopy(pool, polArray);
+	double *grad = (double*) calloc(dof, sizeof(double));
+	double *vel  = (double*) calloc(dof, sizeof(double));
+	const double radius = getRadius();
+
+	const Box b = findBoundary(polArray, n_polygons);
+	const Point center = {(b.xmin + b.xmax) / 2., (b.ymin + b.ymax) / 2.};
+	double side = fmax(b.xmax - b.xmin, b.ymax - b.ymin);
+
+	const int stageSteps = iterationNumber / RELAX_STAGES;
+	int step = 0;
+	for (int stage = 0; stage < RELAX_STAGES && !engine->expired; ++stage) {
+		const double pressure = stage == RELAX_STAGES-1 ? 0. : RELAX_PRESSURE * pow(0.25, stage);
+		double dt = RELAX_DT, alpha = FIRE_ALPHA;
+		int positiveSteps = 0;
+		memset(vel, 0, dof * sizeof(double));
+
+		for (int k = 0; k < stageSteps && !timeIsUp(engine, step); ++k, ++step) {
+			const Box container = squareBox(center, side);
+			relaxEnergy(polArray, n_polygons, &container, pressure, grad);
+
+			double fmaxAbs = 0., power = 0., fnorm2 = 0., vnorm2 = 0.;
+			for (int d = 0; d < dof; ++d) {
+				fmaxAbs = fmax(fmaxAbs, fabs(grad[d]));
+				power -= grad[d] * vel[d];
+				fnorm2 += grad[d] * grad[d];
+				vnorm2 += vel[d] * vel[d];
+			}
+			if (fmaxAbs < RELAX_FORCE_TOL)
+				break;
+
+			if (power > 0.) {
+				const double mix = alpha * sqrt(vnorm2 / fnorm2);
+				for (int d = 0; d < dof; ++d)
+					vel[d] = (1. - alpha) * vel[d] - mix * grad[d];
+				if (++positiveSteps > FIRE_N_MIN) {
+					dt = fmin(dt * FIRE_F_INC, RELAX_DT_MAX);
+					alpha *= FIRE_F_ALPHA;
+				}
+			}
+			else {
+				memset(vel, 0, dof * sizeof(double));
+				dt *= FIRE_F_DEC;
+				alpha = FIRE_ALPHA;
+				positiveSteps = 0;
+			}
+
+			double moveMax = 0.;
+			for (int d = 0; d < dof; ++d) {
+				vel[d] -= dt * grad[d];
+				moveMax = fmax(moveMax, fabs(dt * vel[d]));
+			}
+			const double scale = moveMax > RELAX_MAX_MOVE ? RELAX_MAX_MOVE / moveMax : 1.;
+			for (int i = 0; i < n_polygons; ++i) {
+				translation(polArray + i, scale * dt * vel[3*i], scale * dt * vel[3*i+1]);
+				rotation(polArray + i, scale * dt * vel[3*i+2] / radius);
+			}
+			side += scale * dt * vel[3 * n_polygons];
+		}
+	}
+
+	bool improved = false;
+	if (inflate(polArray, n_polygons, center)) {
+		double newSide = 0, error = 0;
+		findErrorRatio(polArray, n_polygons, &newSide, &error);
+		if (error < sol->error) {
+			sol->bigSquareSide = newSide;
+			sol->error = error;
+			reportImprovement(engine, sol, step, error);
+			improved = true;
+		}
+	}
+	if (!improved)
+		memcpy(polArray, best_polArray, n_polygons * sizeof(Polygon));
+
+	free(vel);
+	free(grad);
+	releaseBuffer(pool, best_polArray);
+	return improved;
+}
@@ -0,0 +1,11 @@
+#ifndef RELAX_H
+#define RELAX_H
+
+#include "settings.h"
+#include "polygons.h"
+#include "engine.h"
+
+double relaxEnergy(const Polygon *polArray, int n_polygons, const Box *container, double pressure, double *grad);
+bool optimize_relax(Engine *engine, Solution *sol, int iterationNumber);
+
+#endif
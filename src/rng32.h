@@ -17,6 +17,10 @@
  *
  *     float rng32_nextFloat(rng32 *rng);
  *
+ * - Filling an array of floats uniformly drawn between 0. and 1., from the given rng:
+ *
+ *     void rng32_fillFloat(rng32 *rng, float *array, int length);
+ *
  * A stream, when available, is useful for producing distincts sequences of random number,
  * from the same rng and the same seed. Finally, RNG32_MAX is the maximum value that the
  * defined 32-bit rng is able to output.
@@ -106,6 +110,12 @@ static inline float rng32_nextFloat(rng32 *rng)
 	return rng32_nextInt(rng) / (float) RNG32_MAX;
 }
 
+static inline void rng32_fillFloat(rng32 *rng, float *array, int length)
+{
+	for (int i = 0; i < length; ++i)
+		array[i] = rng32_nextFloat(rng);
+}
+
 #if __cplusplus
 }
 #endif
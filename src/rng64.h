@@ -25,6 +25,10 @@
  *
  *     float rng64_nextFloat(rng64 *rng);
  *
+ * - Filling an array of floats uniformly drawn between 0. and 1., from the given rng:
+ *
+ *     void rng64_fillFloat(rng64 *rng, float *array, int length);
+ *
  * A stream, when available, is useful for producing distincts sequences of random number,
  * from the same rng and the same seed. Finally, RNG64_MAX is the maximum value that the
  * defined 64-bit rng is able to output.
@@ -93,6 +97,12 @@ static inline float rng64_nextFloat(rng64 *rng)
 	return rng64_nextInt32(rng) / (float) (RNG64_MAX >> 32);
 }
 
+static inline void rng64_fillFloat(rng64 *rng, float *array, int length)
+{
+	for (int i = 0; i < length; ++i)
+		array[i] = rng64_nextFloat(rng);
+}
+
 #if __cplusplus
 }
 #endif
@@ -0,0 +1,171 @@
+/*
+ * Wrapper for a counter-based 32-bit random number generator.
+ *
+ * Same usage as rng32.h and rng64.h, functions are inlined for speed and thread-safe
+ * as long as each thread uses its own rng:
+ *
+ * - Initializing the internal state of the given rng. Each stream is an independent
+ *   substream of the same seed, and selecting one is O(1):
+ *
+ *     void rngcb_init(rngcb *rng, uint64_t seed, uint64_t stream);
+ *
+ * - Generating the next unsigned 32-bit integer, from the given rng:
+ *
+ *     uint32_t rngcb_nextInt(rngcb *rng);
+ *
+ * - Generating a float uniformly in [0, 1), from the given rng:
+ *
+ *     float rngcb_nextFloat(rngcb *rng);
+ *
+ * - Filling an array of floats uniformly drawn in [0, 1), in one call:
+ *
+ *     void rngcb_fillFloat(rngcb *rng, float *array, int length);
+ *
+ * - Jumping ahead of 'distance' 32-bit outputs in O(1):
+ *
+ *     void rngcb_skip(rngcb *rng, uint64_t distance);
+ *
+ * Each output only depends on the seed, the stream and its position in the stream. Thus
+ * a sequence is the same whether it is drawn one value at a time or by arrays, and
+ * whether the block function is vectorized or not. Parallel runs are reproducible as long
+ * as each thread or replica is given its own stream, e.g its index.
+*/
+/* --------------------------------------------------------------------------- */
+/*
+ * What follows is the Philox4x32-10 block function from:
+ *
+ * J. K. Salmon, M. A. Moraes, R. O. Dror and D. E. Shaw,
+ * "Parallel random numbers: as easy as 1, 2, 3", SC11, 2011.
+ *
+ * The 128-bit counter is made of the 64-bit position in the stream (low words),
+ * and of the 64-bit stream index (high words). The seed is the 64-bit key.
+ */
+
+#ifndef RNGCB_H
+#define RNGCB_H
+
+#if __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <limits.h>
+
+typedef struct
+{
+	uint32_t key[2];
+	uint32_t counter[4];
+	uint32_t block[4]; // outputs of the last generated block
+	int index; // next unread output of 'block', 4 when empty
+} rngcb;
+
+#define RNGCB_MAX UINT_MAX
+
+#define RNGCB_M0 (0xD2511F53u)
+#define RNGCB_M1 (0xCD9E8D57u)
+#define RNGCB_W0 (0x9E3779B9u)
+#define RNGCB_W1 (0xBB67AE85u)
+
+// Computes the 4 outputs of the given 128-bit counter. Only 32-bit integer arithmetic
+// is used, hence the results are the same for scalar and vectorized builds.
+static inline void rngcb_block(const uint32_t key[2], const uint32_t counter[4], uint32_t out[4])
+{
+	uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	for (int r = 0; r < 10; ++r) {
+		const uint64_t p0 = (uint64_t) RNGCB_M0 * c0;
+		const uint64_t p1 = (uint64_t) RNGCB_M1 * c2;
+		const uint32_t n0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+		const uint32_t n2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+		c1 = (uint32_t) p1;
+		c3 = (uint32_t) p0;
+		c0 = n0;
+		c2 = n2;
+		k0 += RNGCB_W0;
+		k1 += RNGCB_W1;
+	}
+	out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+}
+
+// Moves the 64-bit position in the stream, i.e the two counter low words.
+static inline void rngcb_advance(rngcb *rng, uint64_t blocks)
+{
+	const uint64_t position = ((uint64_t) rng->counter[1] << 32 | rng->counter[0]) + blocks;
+	rng->counter[0] = (uint32_t) position;
+	rng->counter[1] = (uint32_t) (position >> 32);
+}
+
+static inline uint32_t rngcb_nextInt(rngcb *rng)
+{
+	if (rng->index == 4) {
+		rngcb_block(rng->key, rng->counter, rng->block);
+		rngcb_advance(rng, 1);
+		rng->index = 0;
+	}
+	return rng->block[rng->index++];
+}
+
+__attribute__((unused)) static void rngcb_init(rngcb *rng, uint64_t seed, uint64_t stream)
+{
+	rng->key[0] = (uint32_t) seed;
+	rng->key[1] = (uint32_t) (seed >> 32);
+	rng->counter[0] = 0u;
+	rng->counter[1] = 0u;
+	rng->counter[2] = (uint32_t) stream;
+	rng->counter[3] = (uint32_t) (stream >> 32);
+	rng->index = 4;
+}
+
+__attribute__((unused)) static void rngcb_skip(rngcb *rng, uint64_t distance)
+{
+	// Consuming what is left of the current block first:
+	while (distance > 0 && rng->index < 4) {
+		++rng->index;
+		--distance;
+	}
+	rngcb_advance(rng, distance / 4);
+	for (uint64_t i = 0; i < distance % 4; ++i)
+		rngcb_nextInt(rng);
+}
+
+// Keeps the 24 most significant bits, so that the float is exact and never reaches 1.
+static inline float rngcb_toFloat(uint32_t x)
+{
+	return (x >> 8) * (1.f / 16777216.f);
+}
+
+static inline float rngcb_nextFloat(rngcb *rng)
+{
+	return rngcb_toFloat(rngcb_nextInt(rng));
+}
+
+static inline void rngcb_fillFloat(rngcb *rng, float *array, int length)
+{
+	int i = 0;
+	while (i < length && rng->index < 4)
+		array[i++] = rngcb_toFloat(rng->block[rng->index++]);
+
+	// Whole blocks are independent from each other, and written straight to the array:
+	const uint64_t start = (uint64_t) rng->counter[1] << 32 | rng->counter[0];
+	const int blocks = (length - i) / 4;
+	for (int b = 0; b < blocks; ++b) {
+		const uint64_t position = start + b;
+		const uint32_t counter[4] = {(uint32_t) position, (uint32_t) (position >> 32),
+			rng->counter[2], rng->counter[3]};
+		uint32_t out[4];
+		rngcb_block(rng->key, counter, out);
+		for (int k = 0; k < 4; ++k)
+			array[i + 4*b + k] = rngcb_toFloat(out[k]);
+	}
+	rngcb_advance(rng, blocks);
+	i += 4 * blocks;
+
+	while (i < length)
+		array[i++] = rngcb_nextFloat(rng);
+}
+
+#if __cplusplus
+}
+#endif
+
+#endif
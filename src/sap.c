@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sap.h"
+
+typedef struct
+{
+	double key;
+	int index;
+} SortEntry;
+
+static int compareEntries(const void *a, const void *b)
+{
+	const double ka = ((const SortEntry*) a)->key, kb = ((const SortEntry*) b)->key;
+	return (ka > kb) - (ka < kb);
+}
+
+static void pushFound(SweepAndPrune *sap, int index)
+{
+	if (sap->n_found == sap->foundCapacity) {
+		sap->foundCapacity = sap->foundCapacity ? 2 * sap->foundCapacity : 64;
+		sap->found = (int*) realloc(sap->found, sap->foundCapacity * sizeof(int));
+	}
+	sap->found[sap->n_found++] = index;
+}
+
+SweepAndPrune* createSweepAndPrune(const Polygon *polArray, int n_polygons)
+{
+	SweepAndPrune *sap = (SweepAndPrune*) calloc(1, sizeof(SweepAndPrune));
+	sap->n_polygons = n_polygons;
+	sap->boxes = (Box*) calloc(n_polygons, sizeof(Box));
+	sap->order = (int*) calloc(n_polygons, sizeof(int));
+	sap->rank = (int*) calloc(n_polygons, sizeof(int));
+	sap->maxWidth = 2. * getRadius();
+	sapRebuild(sap, polArray);
+	return sap;
+}
+
+void freeSweepAndPrune(SweepAndPrune *sap)
+{
+	if (!sap)
+		return;
+	free(sap->boxes);
+	free(sap->order);
+	free(sap->rank);
+	free(sap->found);
+	free(sap);
+}
+
+// Sorts everything from scratch, in O(n log(n)).
+void sapRebuild(SweepAndPrune *sap, const Polygon *polArray)
+{
+	const int n_polygons = sap->n_polygons;
+	SortEntry *entries = (SortEntry*) calloc(n_polygons, sizeof(SortEntry));
+	for (int i = 0; i < n_polygons; ++i) {
+		sap->boxes[i] = findBoundary(polArray + i, 1);
+		entries[i] = (SortEntry) {sap->boxes[i].xmin, i};
+	}
+	qsort(entries, n_polygons, sizeof(SortEntry), compareEntries);
+	for (int r = 0; r < n_polygons; ++r) {
+		sap->order[r] = entries[r].index;
+		sap->rank[entries[r].index] = r;
+	}
+	free(entries);
+}
+
+// Refreshes the boxes of the moved polygons, then moves each one to its new place in
+// the order, shifting its neighbours as an insertion sort would.
+void sapUpdate(SweepAndPrune *sap, const Polygon *polArray, const int *moved, int n_moved)
+{
+	for (int k = 0; k < n_moved; ++k) {
+		const int i = moved[k];
+		sap->boxes[i] = findBoundary(polArray + i, 1);
+		const double key = sap->boxes[i].xmin;
+		int r = sap->rank[i];
+		while (r > 0 && sap->boxes[sap->order[r-1]].xmin > key) {
+			sap->order[r] = sap->order[r-1];
+			sap->rank[sap->order[r]] = r;
+			--r;
+		}
+		while (r < sap->n_polygons-1 && sap->boxes[sap->order[r+1]].xmin < key) {
+			sap->order[r] = sap->order[r+1];
+			sap->rank[sap->order[r]] = r;
+			++r;
+		}
+		sap->order[r] = i;
+		sap->rank[i] = r;
+	}
+}
+
+static bool yOverlap(const Box *a, const Box *b)
+{
+	return a->ymin <= b->ymax && b->ymin <= a->ymax;
+}
+
+// Finds the polygons other than 'i' whose boxes overlap 'box', e.g the box of a candidate position
+// of 'i'. The scan starts from the place of 'i', hence is short if 'box' is close to its current one.
+// Returns their number, and stores them in sap->found.
+int sapQuery(SweepAndPrune *sap, int i, const Box *box)
+{
+	sap->n_found = 0;
+	const double from = box->xmin - sap->maxWidth;
+	int r = sap->rank[i];
+	while (r > 0 && sap->boxes[sap->order[r-1]].xmin >= from)
+		--r;
+	while (r < sap->n_polygons && sap->boxes[sap->order[r]].xmin < from)
+		++r;
+	for (; r < sap->n_polygons && sap->boxes[sap->order[r]].xmin <= box->xmax; ++r) {
+		const int j = sap->order[r];
+		if (j != i && sap->boxes[j].xmax >= box->xmin && yOverlap(sap->boxes + j, box))
+			pushFound(sap, j);
+	}
+	return sap->n_found;
+}
+
+// Finds all pairs of overlapping boxes. Returns their number, and stores them
+// in sap->found, two indices per pair.
+int sapOverlaps(SweepAndPrune *sap)
+{
+	sap->n_found = 0;
+	for (int r = 0; r < sap->n_polygons; ++r) {
+		const int i = sap->order[r];
+		const Box *box = sap->boxes + i;
+		for (int s = r+1; s < sap->n_polygons && sap->boxes[sap->order[s]].xmin <= box->xmax; ++s) {
+			const int j = sap->order[s];
+			if (yOverlap(sap->boxes + j, box)) {
+				pushFound(sap, i);
+				pushFound(sap, j);
+			}
+		}
+	}
+	return sap->n_found / 2;
+}
@@ -0,0 +1,30 @@
+#ifndef SAP_H
+#define SAP_H
+
+#include "polygons.h"
+
+// Sweep and prune broad phase: the bounding boxes of the polygons are kept sorted by their
+// lower x bound. Polygons only move a little between two updates, thus the order is repaired
+// by an insertion sort in near linear time. Only pairs of overlapping boxes are reported.
+// Unlike a grid, its cost does not depend on how evenly the polygons are spread.
+typedef struct
+{
+	int n_polygons;
+	Box *boxes;
+	int *order;      // polygons sorted by boxes[].xmin
+	int *rank;       // position of each polygon in 'order'
+	double maxWidth; // no box is wider
+
+	// Results of the last query:
+	int *found;
+	int n_found, foundCapacity;
+} SweepAndPrune;
+
+SweepAndPrune* createSweepAndPrune(const Polygon *polArray, int n_polygons);
+void freeSweepAndPrune(SweepAndPrune *sap);
+void sapRebuild(SweepAndPrune *sap, const Polygon *polArray);
+void sapUpdate(SweepAndPrune *sap, const Polygon *polArray, const int *moved, int n_moved);
+int sapQuery(SweepAndPrune *sap, int i, const Box *box);
+int sapOverlaps(SweepAndPrune *sap);
+
+#endif
@@ -5,6 +5,8 @@
 #include <math.h>
 #include <assert.h>
 #include "search.h"
+#include "overlap.h"
+#include "polish.h"
 
 // Solution init(int n_polygons, rng_type *rng)
 // {
@@ -19,11 +21,16 @@
 // 	return (Solution) {polArray, n_polygons, side, error};
 // }
 
-Solution init(int n_polygons, rng_type *rng)
+Solution init(int n_polygons)
+{
+	return initWith((Polygon*) calloc(n_polygons, sizeof(Polygon)), n_polygons);
+}
+
+// Same as init(), in the given buffer, e.g from a pool.
+Solution initWith(Polygon *polArray, int n_polygons)
 {
 	// const double diameter = 2. * getRadius();
 	const int n_side = (int) sqrtf(n_polygons);
-	Polygon *polArray = (Polygon*) calloc(n_polygons, sizeof(Polygon));
 	for (int k = 0; k < n_polygons; ++k) {
 		const int i = k / n_side, j = k % n_side;
 		const double x = i * (1. + INIT_MARGIN), y = j * (1. + INIT_MARGIN);
@@ -37,26 +44,58 @@ Solution init(int n_polygons, rng_type *rng)
 	return (Solution) {polArray, n_polygons, side, error};
 }
 
-bool optimize_area(Solution *sol, rng_type *rng, int iterationNumber)
+// Candidate evaluation, cheapest test first, each one able to prune the candidate: the side bound
+// in O(n), then checkConfiguration() whose pairs go through the circles, bounding boxes and narrow
+// phase tests of intersects(). Invalid candidates get a few repair rounds before being given up,
+// which may modify them. Returns true if the candidate is valid and improves 'sol'.
+static bool improvingCandidate(Polygon *polArray, int n_polygons, const Solution *sol, double *side, double *error)
+{
+	findErrorRatio(polArray, n_polygons, side, error);
+	if (*error >= sol->error)
+		return false;
+	if (checkConfiguration(polArray, n_polygons))
+		return true;
+	if (REPAIR_ROUNDS <= 0 || !repairOverlaps(polArray, n_polygons, REPAIR_ROUNDS))
+		return false;
+	findErrorRatio(polArray, n_polygons, side, error);
+	return *error < sol->error;
+}
+
+// Polishes the best configuration 'sol', which must be valid.
+static void polishAndReport(Engine *engine, Solution *sol, int iteration)
+{
+	if (polishSolution(sol, POLISH_STEPS))
+		reportImprovement(engine, sol, iteration, sol->error);
+}
+
+bool optimize_area(Engine *engine, Solution *sol, int iterationNumber)
 {
+	rng_type *rng = &engine->rng;
 	const int n_polygons = sol->n_polygons;
 	Polygon *polArray = sol->polArray;
-	Polygon *best_polArray = (Polygon*) calloc(n_polygons, sizeof(Polygon));
-	memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
+
+	// Only the rows of the moved polygons are recomputed at each iteration:
+	OverlapCache *cache = createOverlapCache(polArray, n_polygons);
+	const bool moveAll = AREA_MOVES <= 0 || AREA_MOVES >= n_polygons;
+	const int n_moved = moveAll ? n_polygons : AREA_MOVES;
+	BufferPool *pool = enginePool(engine, n_polygons);
+	int *moved = (int*) calloc(n_moved, sizeof(int));
+	Polygon *saved = acquireBuffer(pool); // n_moved <= n_polygons
 
 	// double weight = 0.1;
 	double weight = 0.5;
 	// double weight = 5.;
 
 	double best_score = INFINITY;
-	for (int i = 0; i < iterationNumber; ++i) {
-		for (int j = 0; j < n_polygons; ++j) {
-			const int idx = j; // trying to move every polygon before evaluating.
-			// const int idx = rng_int(rng) % n_polygons;
-			mutation(rng, polArray + idx);
+	for (int i = 0; i < iterationNumber && !timeIsUp(engine, i); ++i) {
+		for (int j = 0; j < n_moved; ++j) {
+			const int idx = moveAll ? j : (int) (rng_int(rng) % n_polygons);
+			moved[j] = idx;
+			saved[j] = polArray[idx];
+			mutation(rng, &engine->params, polArray + idx);
 		}
 
-		const double area = configurationQuality(polArray, n_polygons);
+		const double area = overlapEvaluate(cache, polArray, moved, n_moved);
 		double side = 0, error = 0;
 		findErrorRatio(polArray, n_polygons, &side, &error);
 
@@ -77,32 +116,37 @@ bool optimize_area(Solution *sol, rng_type *rng, int iterationNumber)
 			best_score = score;
 			sol->bigSquareSide = side;
 			sol->error = error;
-			memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
-			printf("Improvement at iteration %d: %.4f\n", i, best_score);
+			overlapCommit(cache);
+			reportImprovement(engine, sol, i, best_score);
+		}
+		else { // backtracking, in reverse order in case a polygon has been moved twice.
+			for (int j = n_moved-1; j >= 0; --j)
+				polArray[moved[j]] = saved[j];
 		}
-		else // backtracking
-			memcpy(polArray, best_polArray, n_polygons * sizeof(Polygon));
 	}
-	free(best_polArray);
+	releaseBuffer(pool, saved);
+	free(moved);
+	freeOverlapCache(cache);
 	return checkConfiguration(polArray, n_polygons);
 }
 
 // Simulated annealing test
-void optimize_sa(Solution *sol, rng_type *rng, int iterationNumber)
+void optimize_sa(Engine *engine, Solution *sol, int iterationNumber)
 {
+	rng_type *rng = &engine->rng;
 	const int n_polygons = sol->n_polygons;
 	Polygon *polArray = sol->polArray;
-	Polygon *best_polArray = (Polygon*) calloc(n_polygons, sizeof(Polygon));
-	memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
+	BufferPool *pool = enginePool(engine, n_polygons);
+	Polygon *best_polArray = acquireCopy(pool, polArray);
 
-	double lambda = 0.01;
+	double lambda = engine->params.temperature;
 
 	double best_score = INFINITY;
-	for (int i = 0; i < iterationNumber; ++i) {
+	for (int i = 0; i < iterationNumber && !timeIsUp(engine, i); ++i) {
 		for (int j = 0; j < n_polygons; ++j) {
 			const int idx = j; // trying to move every polygon before evaluating.
 			// const int idx = rng_int(rng) % n_polygons;
-			mutation(rng, polArray + idx);
+			mutation(rng, &engine->params, polArray + idx);
 		}
 		if (checkConfiguration(polArray, n_polygons)) {
 			double side = 0, error = 0;
@@ -125,7 +169,7 @@ void optimize_sa(Solution *sol, rng_type *rng, int iterationNumber)
 
 			const double threshold = exp(-lambda * score); // assumes score >= 0.
 			if (i % 1024 == 0) {
-				lambda *= 2.;
+				lambda *= engine->params.cooling;
 				// lambda *= 0.5;
 			}
 
@@ -136,7 +180,7 @@ void optimize_sa(Solution *sol, rng_type *rng, int iterationNumber)
 				sol->bigSquareSide = side;
 				sol->error = error;
 				memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
-				printf("Improvement at iteration %d: %.4f\n", i, side);
+				reportImprovement(engine, sol, i, side);
 
 			}
 			else // backtracking
@@ -145,78 +189,224 @@ void optimize_sa(Solution *sol, rng_type *rng, int iterationNumber)
 		else // backtracking
 			memcpy(polArray, best_polArray, n_polygons * sizeof(Polygon));
 	}
-	free(best_polArray);
+	memcpy(polArray, best_polArray, n_polygons * sizeof(Polygon));
+	releaseBuffer(pool, best_polArray);
 }
 
-void optimize(Solution *sol, rng_type *rng, int iterationNumber)
+void optimize(Engine *engine, Solution *sol, int iterationNumber)
 {
+	rng_type *rng = &engine->rng;
 	const int n_polygons = sol->n_polygons;
 	Polygon *polArray = sol->polArray;
-	Polygon *best_polArray = (Polygon*) calloc(n_polygons, sizeof(Polygon));
-	memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
-	for (int i = 0; i < iterationNumber; ++i) {
+	BufferPool *pool = enginePool(engine, n_polygons);
+	Polygon *best_polArray = acquireCopy(pool, polArray);
+	Parameters params = engine->params;
+	SuccessWindow window = {0, 0};
+	bool unpolished = false;
+	int i = 0;
+	for (; i < iterationNumber && !timeIsUp(engine, i); ++i) {
+		if (POLISH_PERIOD > 0 && i % POLISH_PERIOD == 0 && unpolished) {
+			polishAndReport(engine, sol, i);
+			memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
+			unpolished = false;
+		}
 		for (int j = 0; j < n_polygons; ++j) {
 			const int idx = j; // trying to move every polygon before evaluating.
 			// const int idx = rng_int(rng) % n_polygons;
-			mutation(rng, polArray + idx);
+			mutation(rng, &params, polArray + idx);
 		}
-		if (checkConfiguration(polArray, n_polygons)) {
-			double side = 0, error = 0;
-			findErrorRatio(polArray, n_polygons, &side, &error);
-			if (error < sol->error) { // greedy
-				sol->bigSquareSide = side;
-				sol->error = error;
-				memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
-				printf("Improvement at iteration %d: %.4f\n", i, sol->error);
-			}
+		double side = 0, error = 0;
+		const bool success = improvingCandidate(polArray, n_polygons, sol, &side, &error);
+		growOnSuccess(&params, &engine->params, &window, success);
+		if (success) { // greedy
+			sol->bigSquareSide = side;
+			sol->error = error;
+			memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
+			reportImprovement(engine, sol, i, sol->error);
+			unpolished = true;
 		}
 		else // backtracking
 			memcpy(polArray, best_polArray, n_polygons * sizeof(Polygon));
 	}
-	free(best_polArray);
+	polishAndReport(engine, sol, i);
+	releaseBuffer(pool, best_polArray);
 }
 
-void optimize_2(Solution *sol, rng_type *rng, int iterationNumber)
+void optimize_2(Engine *engine, Solution *sol, int iterationNumber)
 {
+	rng_type *rng = &engine->rng;
 	const int n_polygons = sol->n_polygons;
 	Polygon *polArray = sol->polArray;
-	Polygon* buffer[NEIGHBOURHOOD] = {0};
-	for (int k = 0; k < NEIGHBOURHOOD; ++k) {
-		buffer[k] = (Polygon*) calloc(n_polygons, sizeof(Polygon));
-		memcpy(buffer[k], polArray, n_polygons * sizeof(Polygon));
-	}
+	const int neighbourhood = engine->params.neighbourhood;
+	BufferPool *pool = enginePool(engine, n_polygons);
+	Polygon *buffer[neighbourhood];
+	for (int k = 0; k < neighbourhood; ++k)
+		buffer[k] = acquireCopy(pool, polArray);
+	Parameters params = engine->params;
+	SuccessWindow window = {0, 0};
 
 	// bool progress = true; // to init the buffer
-	for (int i = 0; i < iterationNumber; ++i) {
+	for (int i = 0; i < iterationNumber && !timeIsUp(engine, i); ++i) {
 
 		// if (progress) {
-		// 	for (int k = 0; k < NEIGHBOURHOOD; ++k)
+		// 	for (int k = 0; k < neighbourhood; ++k)
 		// 		memcpy(buffer[k], polArray, n_polygons * sizeof(Polygon));
 		// 	progress = false;
 		// }
 
-		for (int k = 0; k < NEIGHBOURHOOD; ++k) { // for local exploration
+		for (int k = 0; k < neighbourhood; ++k) { // for local exploration
 			for (int j = 0; j < n_polygons; ++j) {
 				const int idx = j; // trying to move every polygon before evaluating.
 				// const int idx = rng_int(rng) % n_polygons;
-				mutation(rng, buffer[k] + idx);
+				mutation(rng, &params, buffer[k] + idx);
 			}
-			if (checkConfiguration(buffer[k], n_polygons)) {
-				double side = 0, error = 0;
-				findErrorRatio(buffer[k], n_polygons, &side, &error);
-				if (error < sol->error) { // greedy
-					// progress = true;
-					sol->bigSquareSide = side;
-					sol->error = error;
-					memcpy(polArray, buffer[k], n_polygons * sizeof(Polygon));
-					printf("Improvement at iteration %d: %.4f\n", i, sol->error);
-				}
+			double side = 0, error = 0;
+			const bool success = improvingCandidate(buffer[k], n_polygons, sol, &side, &error);
+			growOnSuccess(&params, &engine->params, &window, success);
+			if (success) { // greedy
+				// progress = true;
+				sol->bigSquareSide = side;
+				sol->error = error;
+				memcpy(polArray, buffer[k], n_polygons * sizeof(Polygon));
+				reportImprovement(engine, sol, i, sol->error);
 			}
 			else // backtracking
 				memcpy(buffer[k], polArray, n_polygons * sizeof(Polygon)); // may not be up to date
 		}
 
 	}
-	for (int k = 0; k < NEIGHBOURHOOD; ++k)
-		free(buffer[k]);
+	for (int k = 0; k < neighbourhood; ++k)
+		releaseBuffer(pool, buffer[k]);
+}
+
+// Bisection on the side L of a square container centered on the packing, between the area lower bound
+// and the current side, 'trial' trying to make the configuration fit in the container of each L. Each
+// trial is warm-started from the last feasible configuration, squeezed toward the container center.
+// The solution only takes strictly better configurations, so that its error matches its polygons.
+// Returns true if the solution has been improved.
+bool bisectSide(Engine *engine, Solution *sol, SideTrial trial, void *data)
+{
+	const int n_polygons = sol->n_polygons;
+	Polygon *polArray = sol->polArray;
+	BufferPool *pool = enginePool(engine, n_polygons);
+	Polygon *best_polArray = acquireCopy(pool, polArray);
+	Polygon *restart = acquireCopy(pool, polArray); // last feasible configuration
+
+	const Box b = findBoundary(polArray, n_polygons);
+	const Point center = {(b.xmin + b.xmax) / 2., (b.ymin + b.ymax) / 2.};
+	double lo = sqrt(n_polygons), hi = sol->bigSquareSide;
+	bool improved = false;
+	int iteration = 0;
+
+	for (int round = 0; round < FEASIBILITY_ROUNDS && hi - lo > EPSILON && !engine->expired; ++round) {
+		const double side = (lo + hi) / 2.;
+		const Box container = {center.x - side/2., center.x + side/2., center.y - side/2., center.y + side/2.};
+
+		const double ratio = side / hi - 1.;
+		for (int i = 0; i < n_polygons; ++i) {
+			polArray[i] = restart[i];
+			translation(polArray + i, ratio * (polArray[i].center.x - center.x), ratio * (polArray[i].center.y - center.y));
+		}
+
+		if (trial(data, polArray, &container, &iteration)) {
+			double newSide = 0, error = 0;
+			findErrorRatio(polArray, n_polygons, &newSide, &error);
+			hi = newSide;
+			memcpy(restart, polArray, n_polygons * sizeof(Polygon));
+			if (error < sol->error) {
+				memcpy(best_polArray, polArray, n_polygons * sizeof(Polygon));
+				sol->bigSquareSide = newSide;
+				sol->error = error;
+				reportImprovement(engine, sol, iteration, error);
+				improved = true;
+			}
+		}
+		else
+			lo = side;
+	}
+	memcpy(polArray, best_polArray, n_polygons * sizeof(Polygon));
+	releaseBuffer(pool, restart);
+	releaseBuffer(pool, best_polArray);
+	return improved;
+}
+
+typedef struct
+{
+	Engine *engine;
+	int n_polygons;
+	int stepsPerSide;
+	OverlapCache *cache;
+	double *protrusions;
+} FeasibilityTrial;
+
+// Minimizes the penalty, overlaps plus protrusions, both updated incrementally, until it vanishes.
+static bool feasibilityTrial(void *data, Polygon *polArray, const Box *container, int *iteration)
+{
+	FeasibilityTrial *t = (FeasibilityTrial*) data;
+	Engine *engine = t->engine;
+	rng_type *rng = &engine->rng;
+	const int n_polygons = t->n_polygons;
+	OverlapCache *cache = t->cache;
+	double *protrusions = t->protrusions;
+
+	overlapResync(cache, polArray);
+	double outside = 0.;
+	for (int i = 0; i < n_polygons; ++i) {
+		protrusions[i] = protrusionArea(polArray + i, container);
+		outside += protrusions[i];
+	}
+	double penalty = cache->total + outside;
+
+	for (int step = 0; step < t->stepsPerSide && penalty > engine->params.epsilon; ++step, ++*iteration) {
+		if (timeIsUp(engine, *iteration))
+			break;
+		const int idx = rng_int(rng) % n_polygons;
+		const Polygon saved = polArray[idx];
+		signedMutation(rng, &engine->params, polArray + idx);
+		const double protrusion = protrusionArea(polArray + idx, container);
+		const double newOutside = outside - protrusions[idx] + protrusion;
+		const double newPenalty = overlapEvaluate(cache, polArray, &idx, 1) + newOutside;
+		if (newPenalty <= penalty) {
+			overlapCommit(cache);
+			protrusions[idx] = protrusion;
+			outside = newOutside;
+			penalty = newPenalty;
+		}
+		else // backtracking
+			polArray[idx] = saved;
+	}
+	return penalty <= engine->params.epsilon && checkConfiguration(polArray, n_polygons);
+}
+
+// Fixed container strategy: for a given side L, the penalty (overlaps as in configurationQuality(),
+// and protrusions) is minimized until it reaches 0, in which case L is feasible. L is then found by
+// bisection, see bisectSide().
+// Returns true if the solution has been improved.
+bool optimize_feasibility(Engine *engine, Solution *sol, int iterationNumber)
+{
+	const int n_polygons = sol->n_polygons;
+	FeasibilityTrial trial = {engine, n_polygons, iterationNumber / FEASIBILITY_ROUNDS,
+		createOverlapCache(sol->polArray, n_polygons), (double*) calloc(n_polygons, sizeof(double))};
+	const bool improved = bisectSide(engine, sol, feasibilityTrial, &trial);
+	free(trial.protrusions);
+	freeOverlapCache(trial.cache);
+	return improved;
+}
+
+// Runs the engine chosen in the parameters, e.g tuned ones.
+void runOptimizer(Engine *engine, Solution *sol, int iterationNumber)
+{
+	switch (engine->params.optimizer) {
+	case OPTIMIZER_NEIGHBOURHOOD:
+		optimize_2(engine, sol, iterationNumber);
+		break;
+	case OPTIMIZER_ANNEALING:
+		optimize_sa(engine, sol, iterationNumber);
+		break;
+	case OPTIMIZER_MOVES:
+		optimize_moves(engine, sol, iterationNumber);
+		break;
+	default:
+		optimize(engine, sol, iterationNumber);
+	}
 }
@@ -3,11 +3,20 @@
 
 #include "settings.h"
 #include "polygons.h"
+#include "engine.h"
 
-Solution init(int n_polygons, rng_type *rng);
-bool optimize_area(Solution *sol, rng_type *rng, int iterationNumber);
-void optimize_sa(Solution *sol, rng_type *rng, int iterationNumber);
-void optimize(Solution *sol, rng_type *rng, int iterationNumber);
-void optimize_2(Solution *sol, rng_type *rng, int iterationNumber);
+// Called by bisectSide() for each side, 'polArray' being squeezed toward 'container' and 'iteration'
+// counting the iterations of all trials. Returns true if 'polArray' has been made valid and within 'container'.
+typedef bool (*SideTrial)(void *data, Polygon *polArray, const Box *container, int *iteration);
+
+Solution init(int n_polygons);
+Solution initWith(Polygon *polArray, int n_polygons);
+bool optimize_area(Engine *engine, Solution *sol, int iterationNumber);
+void optimize_sa(Engine *engine, Solution *sol, int iterationNumber);
+void optimize(Engine *engine, Solution *sol, int iterationNumber);
+void optimize_2(Engine *engine, Solution *sol, int iterationNumber);
+bool bisectSide(Engine *engine, Solution *sol, SideTrial trial, void *data);
+bool optimize_feasibility(Engine *engine, Solution *sol, int iterationNumber);
+void runOptimizer(Engine *engine, Solution *sol, int iterationNumber);
 
 #endif
@@ -3,6 +3,12 @@
 
 #define N_SIDES (4)
 
+// Engines are aligned on this, to avoid false sharing between threads:
+#define CACHE_LINE (64)
+
+// Configuration buffers allocated at once by a pool, see pool.h:
+#define POOL_CHUNK (16)
+
 // Polygons functions settings:
 #define EPSILON        (1.e-9)
 #define INIT_MARGIN    (0.50)
@@ -10,6 +16,7 @@
 #define NEIGHBOURHOOD  (10)
 #define ROTATION_RANGE (0.05)
 
+// Default engine parameters, see params.h.
 // Those work well with n_polygons = 5
 #define ROTATION_PROBA (0.15f)
 #define STEP_SIZE      (0.05f)
@@ -18,6 +25,113 @@
 // #define ROTATION_PROBA ((float) 0.25f)
 // #define STEP_SIZE      ((float) 0.1)
 
+// Engine run by runOptimizer(), see params.h, and schedule of optimize_sa():
+#define OPTIMIZER   (OPTIMIZER_MOVES)
+#define TEMPERATURE (0.01)
+#define COOLING     (2.)
+
+// optimize() and optimize_2() grow the step size and rotation probability after windows of
+// STEP_ADAPT_PERIOD candidates with an improvement, and shrink them otherwise, see growOnSuccess().
+// The above values, tuned ones included, are thus only where the step restarts from once below
+// STEP_MIN, and are overridden within a few windows. This mostly helps when they are too large for
+// the number of polygons, being within the seed noise otherwise. 0 keeps them fixed, e.g to tune them:
+#define STEP_ADAPT_PERIOD  (64)
+#define STEP_ADAPT_FACTOR  (1.2)
+#define STEP_MIN           (1.e-4)
+#define STEP_MAX           (0.5)
+#define ROTATION_PROBA_MIN (0.01)
+#define ROTATION_PROBA_MAX (0.5)
+
+// Wall-clock budget of a search in seconds, 0 for none. Engines then stop at the deadline, the
+// monotonic clock being read every TIME_CHECK_PERIOD iterations (must be a power of 2):
+#define TIME_BUDGET       (0.)
+#define TIME_CHECK_PERIOD (256)
+
+// Broad phase of the overlap cache and of the decomposition engine checks, instead of testing
+// all pairs, resp. cells one diameter wide. Better when polygons are very unevenly spread:
+#define SWEEP_AND_PRUNE
+
+// checkConfiguration() looks pairs up in a table of no-fit polygons, one per quantized relative
+// angle, falling back to the exact test near their boundary:
+#define NO_FIT_POLYGONS
+#define NFP_ANGLES (256)
+
+// Rounds of minimum translation vector pushes given to invalid candidates of optimize()
+// and optimize_2() before backtracking, 0 to backtrack at once:
+#define REPAIR_ROUNDS (4)
+
+// Polishing of the best configuration by linearized simultaneous moves, see polish.c. Run by optimize()
+// every POLISH_PERIOD iterations (0 for never) when improved meanwhile, and at the end:
+#define POLISH_PERIOD       (16384)
+#define POLISH_STEPS        (30)      // LPs per polishing
+#define POLISH_TRUST        (0.01)    // max initial move of a polygon, along x and y
+#define POLISH_MIN_TRUST    (1.e-12)
+#define POLISH_GAP          (1.e-9)   // min distance kept between polygons, contacts being degenerate
+#define POLISH_TOL          (1.e-15)  // relative side gain below which an LP step is not tried
+#define POLISH_PIVOTS       (2000)    // per LP, the last basic solution being feasible anyway
+#define POLISH_MAX_POLYGONS (300)     // dense LPs beyond that, polishing is skipped
+
+// Polygons mutated per optimize_area() iteration, 0 for all of them:
+#define AREA_MOVES (0)
+
+// Critical set engine settings, see critical.h:
+#define CRITICAL_DEPTH      (2)    // contact levels behind the polygons on the box sides
+#define CRITICAL_PERIOD     (64)   // iterations between two updates, done anyway on progress
+#define CRITICAL_RATE       (0.05) // of the class weights moving averages
+#define CRITICAL_MIN_WEIGHT (0.05)
+
+// Move operators engine settings, see moves.h:
+#define MOVES_RATE      (0.01) // of the operators reward and time moving averages
+#define MOVES_EXPLORE   (0.5)  // probability of picking an operator uniformly
+#define MOVES_SCALE_UP  (1.1)  // per polygon step scale factor on acceptance, see adaptStepScale()
+#define MOVES_TARGET    (0.2)  // acceptance rate at which the scales are stationary
+#define MOVES_MIN_SCALE (0.01)
+#define MOVES_MAX_SCALE (4.)
+
+// Fixed container engine settings:
+#define FEASIBILITY_ROUNDS (20) // bisection steps on the container side
+
+// Decomposition engine settings, for large n:
+#define TILE_POLYGONS     (64) // polygons per tile, roughly
+#define TILE_SWEEPS       (8)  // per container side, every other sweep has tiles shifted by half a tile
+#define DECOMPOSE_THREADS (4)
+
+// Event-driven compression engine settings, velocities being about 1:
+#define COMPRESS_GROWTH   (0.01)  // polygons size is 1 + COMPRESS_GROWTH * t
+#define COMPRESS_GAP      (1.e-7) // distance at which polygons collide
+#define COMPRESS_CA_STEPS (64)    // conservative advancement steps per prediction and partner
+#define COMPRESS_HORIZON  (1.)    // max time between two predictions of a particle
+#define COMPRESS_PERIOD   (4)     // thermostat and jamming checks every COMPRESS_PERIOD * n_polygons events
+#define COMPRESS_JAM_TOL  (1.e-7) // relative growth between two checks, below which the packing is jammed
+
+// Relaxation engine settings:
+#define RELAX_PRESSURE  (0.05) // initial pressure on the container side
+#define RELAX_STAGES    (8)    // the pressure is divided by 4 at each stage, and is 0 at the last one
+#define RELAX_FORCE_TOL (1.e-12)
+#define RELAX_DT        (0.05)
+#define RELAX_DT_MAX    (0.5)
+#define RELAX_MAX_MOVE  (0.02) // max coordinate change per step
+
+// Tuning mode, './packing.exe tune [n_polygons...]': parameters raced on all cores, see tune.c,
+// for each number of polygons, and saved to PARAMS_FILE. This file is loaded at startup, if any:
+#define PARAMS_FILE      "params.txt"
+#define TUNE_SIZES       {5, 7, 10, 20, 40} // default numbers of polygons
+#define TUNE_BUDGET      (1.)  // seconds per run
+#define TUNE_CANDIDATES  (16)  // per race
+#define TUNE_ELITES      (4)   // best candidates of a race, raced again in the next one
+#define TUNE_ITERATIONS  (3)   // races per number of polygons
+#define TUNE_MAX_SEEDS   (20)  // instances per race
+#define TUNE_FIRST_TEST  (5)   // instances before candidates can be dropped
+#define TUNE_ALPHA       (0.05) // significance level of the tests
+#define TUNE_SEED        (1)
+
+// Improvements are logged by a background thread, so that search threads never make syscalls:
+#define ASYNC_LOGGING
+#define LOG_RING_SIZE (1024) // events per search thread, must be a power of 2
+#define LOG_RATE      (50)   // max events written per second, 0 for no limit
+#define LOG_PERIOD_MS (20)   // logger thread wake up period
+// #define LOG_BINARY        // LogEvent records written to EXPORT_NAME.log, instead of text on stdout
+
 // Graphic settings:
 #define WINDOW_WIDTH  (1200)
 #define WINDOW_HEIGHT (1000)
@@ -27,25 +141,45 @@
 #define QUIT_KEY_1 (SDLK_ESCAPE)
 #define QUIT_KEY_2 (SDLK_q)
 
+// Shows the best-so-far solution during the search, from a separate render thread:
+#define LIVE_RENDERING
+#define LIVE_FPS        (30)
+
 #define FONT_NAME ("/usr/share/fonts/truetype/dejavu/DejaVuSerif-Bold.ttf")
 
+// Export settings, final configurations are written to EXPORT_NAME.svg (and .png):
+#define EXPORT_NAME "packing"
+#define EXPORT_PNG
+
 
 // Somehow, the rng64 does not help at all. This might be
 // due to the search over sensibility to small changes.
-#define RNG32
+// The counter-based rng (RNGCB) fills arrays of floats in one call, and
+// gives each thread or replica its own substream in O(1) through 'stream'.
+// #define RNG32
+#define RNGCB
 
-#ifdef RNG32
+#if defined(RNGCB)
+#include "rngcb.h"
+#define rng_type rngcb
+#define rng_init rngcb_init
+#define rng_int  rngcb_nextInt
+#define rng_real rngcb_nextFloat
+#define rng_fill rngcb_fillFloat
+#elif defined(RNG32)
 #include "rng32.h"
 #define rng_type rng32
 #define rng_init rng32_init
 #define rng_int  rng32_nextInt
 #define rng_real rng32_nextFloat
+#define rng_fill rng32_fillFloat
 #else
 #include "rng64.h"
 #define rng_type rng64
 #define rng_init rng64_init
 #define rng_int  rng64_nextInt
 #define rng_real rng64_nextDouble
+#define rng_fill rng64_fillFloat
 #endif
 
 #endif
@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "snapshot.h"
+
+#define SNAPSHOT_FRESH (4) // flag set on 'spare' when it holds an unread snapshot.
+
+SnapshotBuffer* createSnapshotBuffer(int n_polygons)
+{
+	SnapshotBuffer *buffer = (SnapshotBuffer*) calloc(1, sizeof(SnapshotBuffer));
+	for (int k = 0; k < 3; ++k) {
+		buffer->slots[k].polArray = (Polygon*) calloc(n_polygons, sizeof(Polygon));
+		buffer->slots[k].n_polygons = n_polygons;
+		buffer->slots[k].iteration = -1; // nothing published yet
+	}
+	buffer->back = 0;
+	buffer->front = 1;
+	buffer->spare = 2;
+	return buffer;
+}
+
+void freeSnapshotBuffer(SnapshotBuffer *buffer)
+{
+	if (!buffer)
+		return;
+	for (int k = 0; k < 3; ++k)
+		free(buffer->slots[k].polArray);
+	free(buffer);
+}
+
+// Called by the search thread. Never blocks: the back slot is filled,
+// then exchanged with the spare one.
+void publishSnapshot(SnapshotBuffer *buffer, const Solution *sol, int iteration)
+{
+	Snapshot *snap = buffer->slots + buffer->back;
+	memcpy(snap->polArray, sol->polArray, snap->n_polygons * sizeof(Polygon));
+	snap->bigSquareSide = sol->bigSquareSide;
+	snap->error = sol->error;
+	snap->iteration = iteration;
+	const int previous = __atomic_exchange_n(&buffer->spare, buffer->back | SNAPSHOT_FRESH, __ATOMIC_ACQ_REL);
+	buffer->back = previous & ~SNAPSHOT_FRESH;
+}
+
+// Called by the render thread. Returns the most recent snapshot, and sets 'fresh'
+// to true if it has not been returned before. Never blocks either.
+const Snapshot* latestSnapshot(SnapshotBuffer *buffer, bool *fresh)
+{
+	*fresh = __atomic_load_n(&buffer->spare, __ATOMIC_ACQUIRE) & SNAPSHOT_FRESH;
+	if (*fresh) {
+		const int previous = __atomic_exchange_n(&buffer->spare, buffer->front, __ATOMIC_ACQ_REL);
+		buffer->front = previous & ~SNAPSHOT_FRESH;
+	}
+	return buffer->slots + buffer->front;
+}
@@ -0,0 +1,33 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+#include "polygons.h"
+
+// Copy of a configuration, as published by a search thread.
+typedef struct
+{
+	Polygon *polArray;
+	int n_polygons;
+	double bigSquareSide;
+	double error;
+	int iteration;
+} Snapshot;
+
+// Lock-free double buffering between one writer (the search thread) and one reader
+// (the render thread). A third, spare slot is swapped atomically between them, so that
+// the writer never waits for the reader to be done with the front slot, and conversely.
+typedef struct
+{
+	Snapshot slots[3];
+	int back;   // only used by the writer
+	int front;  // only used by the reader
+	int spare;  // slot index, plus SNAPSHOT_FRESH when not read yet. Atomic.
+} SnapshotBuffer;
+
+SnapshotBuffer* createSnapshotBuffer(int n_polygons);
+void freeSnapshotBuffer(SnapshotBuffer *buffer);
+void publishSnapshot(SnapshotBuffer *buffer, const Solution *sol, int iteration);
+const Snapshot* latestSnapshot(SnapshotBuffer *buffer, bool *fresh);
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "swept.h"
+
+static const double Pi = 3.14159265359;
+
+// Smallest t >= 0 such that P + t.d lies on the segment [A, B], or INFINITY. 'gap' is a distance
+// to keep from the edge, along its outward normal. Only edges crossed from the outside count:
+// polygons are counterclockwise, and moving away from a touching edge is allowed.
+static double timeOfImpact(const Point *P, Point d, const Point *A, const Point *B, double gap)
+{
+	const double ex = B->x - A->x, ey = B->y - A->y;
+	const double approach = -(d.x * ey - d.y * ex) / sqrt(ex * ex + ey * ey); // -d.n, n outward unit normal
+	if (approach <= 0.)
+		return INFINITY;
+	const double denom = d.x * ey - d.y * ex;
+	const double wx = A->x - P->x, wy = A->y - P->y;
+	const double t = (wx * ey - wy * ex) / denom;
+	const double s = (wx * d.y - wy * d.x) / denom;
+	if (s < 0. || s > 1. || t < -gap / approach)
+		return INFINITY;
+	return fmax(t - gap / approach, 0.);
+}
+
+// Vertices of each polygon against the edges of the other, the second one moving backward.
+static double pairTimeOfImpact(const Polygon *moving, const Polygon *other, Point d)
+{
+	const Point back = {-d.x, -d.y};
+	double t = INFINITY;
+	for (int i = 0; i < N_SIDES; ++i) {
+		const Point *A = other->points + i, *B = other->points + (i+1) % N_SIDES;
+		const Point *C = moving->points + i, *D = moving->points + (i+1) % N_SIDES;
+		for (int j = 0; j < N_SIDES; ++j) {
+			t = fmin(t, timeOfImpact(moving->points + j, d, A, B, EPSILON));
+			t = fmin(t, timeOfImpact(other->points + j, back, C, D, EPSILON));
+		}
+	}
+	return t;
+}
+
+// Largest distance, at most 'limit', polygon 'idx' can be translated by along the unit vector
+// 'direction' without touching another polygon nor leaving the container.
+double maxTranslation(const Polygon *polArray, int n_polygons, int idx, Point direction, double limit, const Box *container)
+{
+	const Polygon *pol = polArray + idx;
+	const double reach = sqrt(getDiam2()) + limit;
+	double t = limit;
+	for (int j = 0; j < n_polygons; ++j) {
+		if (j != idx && distance2(&(pol->center), &(polArray[j].center)) < reach * reach)
+			t = fmin(t, pairTimeOfImpact(pol, polArray + j, direction));
+	}
+	for (int i = 0; i < N_SIDES; ++i) {
+		const Point *p = pol->points + i;
+		if (direction.x > 0.)
+			t = fmin(t, (container->xmax - p->x) / direction.x);
+		else if (direction.x < 0.)
+			t = fmin(t, (container->xmin - p->x) / direction.x);
+		if (direction.y > 0.)
+			t = fmin(t, (container->ymax - p->y) / direction.y);
+		else if (direction.y < 0.)
+			t = fmin(t, (container->ymin - p->y) / direction.y);
+	}
+	return fmax(t, 0.);
+}
+
+// Largest angle, at most 'limit', polygon 'idx' can be rotated by in either direction. Conservative:
+// vertices move by at most radius * angle, which must stay below the distance to the neighbours.
+double maxRotation(const Polygon *polArray, int n_polygons, int idx, double limit, const Box *container)
+{
+	const Polygon *pol = polArray + idx;
+	const double r = getRadius();
+	double clearance = r * limit + EPSILON;
+	for (int i = 0; i < N_SIDES; ++i) {
+		clearance = fmin(clearance, fmin(pol->points[i].x - container->xmin, container->xmax - pol->points[i].x));
+		clearance = fmin(clearance, fmin(pol->points[i].y - container->ymin, container->ymax - pol->points[i].y));
+	}
+	// Rotated vertices stay in the circumscribed circle, which may itself be inside the container:
+	const Box b = {pol->center.x - r, pol->center.x + r, pol->center.y - r, pol->center.y + r};
+	if (b.xmin >= container->xmin && b.xmax <= container->xmax && b.ymin >= container->ymin && b.ymax <= container->ymax)
+		clearance = r * limit + EPSILON;
+	const double reach = sqrt(getDiam2()) + clearance;
+	for (int j = 0; j < n_polygons; ++j) {
+		if (j != idx && distance2(&(pol->center), &(polArray[j].center)) < reach * reach) {
+			Point A, B;
+			clearance = fmin(clearance, polygonsDistance(pol->points, N_SIDES, polArray[j].points, N_SIDES, &A, &B));
+		}
+	}
+	return fmax(fmin((clearance - EPSILON) / r, limit), 0.);
+}
+
+// Feasible moves only: each step picks a polygon and a direction, then moves it as far as possible
+// along it, given the step size, its neighbours and the bounding box of the configuration. The box
+// can only shrink, and no move is ever rejected. Translations are directed toward the box center.
+// The given solution must be valid. Returns true if it has been improved.
+bool optimize_swept(Engine *engine, Solution *sol, int iterationNumber)
+{
+	rng_type *rng = &engine->rng;
+	const int n_polygons = sol->n_polygons;
+	Polygon *polArray = sol->polArray;
+	if (!checkConfiguration(polArray, n_polygons)) {
+		printf("optimize_swept() needs a valid configuration.\n");
+		return false;
+	}
+	Box box = findBoundary(polArray, n_polygons);
+	bool improved = false;
+
+	for (int i = 0; i < iterationNumber && !timeIsUp(engine, i); ++i) {
+		float u[3];
+		rng_fill(rng, u, 3);
+		const int idx = rng_int(rng) % n_polygons;
+		Polygon *pol = polArray + idx;
+		const Box before = findBoundary(pol, 1);
+
+		if (u[0] < engine->params.rotationProba) {
+			const double angle = maxRotation(polArray, n_polygons, idx, engine->params.rotationProba / 2., &box);
+			rotation(pol, u[1] < 0.5f ? angle : -angle);
+		}
+		else {
+			const double theta = 2. * Pi * u[1];
+			Point d = {cos(theta), sin(theta)};
+			if (d.x * ((box.xmin + box.xmax) / 2. - pol->center.x) + d.y * ((box.ymin + box.ymax) / 2. - pol->center.y) < 0.)
+				d = (Point) {-d.x, -d.y};
+			const double t = maxTranslation(polArray, n_polygons, idx, d, engine->params.stepSize, &box);
+			translation(pol, t * d.x, t * d.y);
+		}
+
+		// The box only changes if the polygon was on its boundary:
+		if (before.xmin <= box.xmin || before.xmax >= box.xmax || before.ymin <= box.ymin || before.ymax >= box.ymax) {
+			box = findBoundary(polArray, n_polygons);
+			double side = 0, error = 0;
+			findErrorRatio(polArray, n_polygons, &side, &error);
+			if (error < sol->error) {
+				sol->bigSquareSide = side;
+				sol->error = error;
+				reportImprovement(engine, sol, i, error);
+				improved = true;
+			}
+		}
+	}
+	return improved;
+}
@@ -0,0 +1,12 @@
+#ifndef SWEPT_H
+#define SWEPT_H
+
+#include <stdbool.h>
+#include "polygons.h"
+#include "engine.h"
+
+double maxTranslation(const Polygon *polArray, int n_polygons, int idx, Point direction, double limit, const Box *container);
+double maxRotation(const Polygon *polArray, int n_polygons, int idx, double limit, const Box *container);
+bool optimize_swept(Engine *engine, Solution *sol, int iterationNumber);
+
+#endif
@@ -0,0 +1,364 @@
+#define _POSIX_C_SOURCE 200112L // for sysconf()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "tune.h"
+#include "engine.h"
+#include "search.h"
+
+// Sampled ranges, the first two and the temperature being sampled on a log scale. The step size and
+// rotation probability are only initial values of optimize() and optimize_2(), see STEP_ADAPT_PERIOD:
+#define TUNE_STEP_MIN        (0.005)
+#define TUNE_STEP_MAX        (0.5)
+#define TUNE_ROTATION_MIN    (0.01)
+#define TUNE_ROTATION_MAX    (0.5)
+#define TUNE_TEMPERATURE_MIN (0.001)
+#define TUNE_TEMPERATURE_MAX (1.)
+#define TUNE_COOLING_MIN     (1.1)
+#define TUNE_COOLING_MAX     (4.)
+
+static const double Pi = 3.14159265359;
+
+typedef struct
+{
+	Parameters params;
+	bool alive;
+	double costs[TUNE_MAX_SEEDS]; // final error ratio on each instance, i.e seed
+} Candidate;
+
+typedef struct
+{
+	int n_polygons;
+	int instance;
+	Candidate *candidates;
+	int *jobs; // alive candidates
+	int n_jobs;
+	int next;
+} Race;
+
+/////////////////////////////////////////////
+// Sampling:
+/////////////////////////////////////////////
+
+static double normal(rng_type *rng)
+{
+	const double u = 1. - rng_real(rng), v = rng_real(rng); // u > 0
+	return sqrt(-2. * log(u)) * cos(2. * Pi * v);
+}
+
+static double logUniform(rng_type *rng, double min, double max)
+{
+	return min * pow(max / min, rng_real(rng));
+}
+
+// Perturbation of 'x' by a normal of standard deviation 'spread' times the range, on a log scale if asked.
+static double perturb(rng_type *rng, double x, double min, double max, double spread, bool logScale)
+{
+	const double y = logScale ? x * pow(max / min, spread * normal(rng)) : x + spread * (max - min) * normal(rng);
+	return fmin(fmax(y, min), max);
+}
+
+// Uniform over the space if 'parent' is NULL, else around it, as irace does around elite configurations.
+static Parameters sample(rng_type *rng, const Parameters *parent, double spread)
+{
+	Parameters p = defaultParameters();
+	if (!parent) {
+		p.stepSize = logUniform(rng, TUNE_STEP_MIN, TUNE_STEP_MAX);
+		p.rotationProba = logUniform(rng, TUNE_ROTATION_MIN, TUNE_ROTATION_MAX);
+		p.neighbourhood = 1 + rng_int(rng) % (2 * NEIGHBOURHOOD);
+		p.temperature = logUniform(rng, TUNE_TEMPERATURE_MIN, TUNE_TEMPERATURE_MAX);
+		p.cooling = TUNE_COOLING_MIN + (TUNE_COOLING_MAX - TUNE_COOLING_MIN) * rng_real(rng);
+		p.optimizer = (Optimizer) (rng_int(rng) % N_OPTIMIZERS);
+		return p;
+	}
+	p.stepSize = perturb(rng, parent->stepSize, TUNE_STEP_MIN, TUNE_STEP_MAX, spread, true);
+	p.rotationProba = perturb(rng, parent->rotationProba, TUNE_ROTATION_MIN, TUNE_ROTATION_MAX, spread, true);
+	p.neighbourhood = (int) round(perturb(rng, parent->neighbourhood, 1, 2 * NEIGHBOURHOOD, spread, false));
+	p.temperature = perturb(rng, parent->temperature, TUNE_TEMPERATURE_MIN, TUNE_TEMPERATURE_MAX, spread, true);
+	p.cooling = perturb(rng, parent->cooling, TUNE_COOLING_MIN, TUNE_COOLING_MAX, spread, false);
+	p.optimizer = rng_real(rng) < spread ? (Optimizer) (rng_int(rng) % N_OPTIMIZERS) : parent->optimizer;
+	return p;
+}
+
+/////////////////////////////////////////////
+// Statistics:
+/////////////////////////////////////////////
+
+// Abramowitz and Stegun 26.2.23, absolute error below 4.5e-4. 'p' must be in [0.5, 1).
+static double normalQuantile(double p)
+{
+	const double t = sqrt(-2. * log(1. - p));
+	return t - (2.515517 + t * (0.802853 + t * 0.010328)) / (1. + t * (1.432788 + t * (0.189269 + t * 0.001308)));
+}
+
+// Wilson-Hilferty approximation.
+static double chi2Quantile(double p, int df)
+{
+	const double a = 2. / (9. * df), c = 1. - a + normalQuantile(p) * sqrt(a);
+	return df * c * c * c;
+}
+
+// Cornish-Fisher expansion, good enough for the degrees of freedom of a race.
+static double studentQuantile(double p, int df)
+{
+	const double z = normalQuantile(p), z2 = z * z;
+	return z + z * (z2 + 1.) / (4. * df) + z * ((5. * z2 + 16.) * z2 + 3.) / (96. * df * df)
+		+ z * (((3. * z2 + 19.) * z2 + 17.) * z2 - 15.) / (384. * df * df * df);
+}
+
+// Ranks of the alive candidates on an instance, ties getting their average rank.
+static void rankInstance(const Candidate *candidates, const int *alive, int k, int instance, double *ranks)
+{
+	for (int a = 0; a < k; ++a) {
+		const double cost = candidates[alive[a]].costs[instance];
+		int below = 0, equal = 0;
+		for (int b = 0; b < k; ++b) {
+			const double other = candidates[alive[b]].costs[instance];
+			below += other < cost;
+			equal += other == cost;
+		}
+		ranks[a] = below + (equal + 1) / 2.;
+	}
+}
+
+// Friedman test on the 'n_instances' instances run so far, followed as in irace by the comparisons of
+// each candidate with the best one, i.e of lowest rank sum, the candidates significantly worse being
+// dropped. Returns the index of the best one.
+static int friedmanRace(Candidate *candidates, int n_candidates, int n_instances)
+{
+	int alive[n_candidates], k = 0;
+	for (int c = 0; c < n_candidates; ++c) {
+		if (candidates[c].alive)
+			alive[k++] = c;
+	}
+	double R[k], ranks[k], A = 0.;
+	memset(R, 0, sizeof(R));
+	for (int i = 0; i < n_instances; ++i) {
+		rankInstance(candidates, alive, k, i, ranks);
+		for (int a = 0; a < k; ++a) {
+			R[a] += ranks[a];
+			A += ranks[a] * ranks[a];
+		}
+	}
+	int best = 0;
+	double sumR2 = 0., T = 0.;
+	for (int a = 0; a < k; ++a) {
+		best = R[a] < R[best] ? a : best;
+		sumR2 += R[a] * R[a];
+		T += (R[a] - n_instances * (k + 1) / 2.) * (R[a] - n_instances * (k + 1) / 2.);
+	}
+	const int b = n_instances;
+	const double C = b * k * (k + 1.) * (k + 1.) / 4.;
+	if (k < 2 || b < TUNE_FIRST_TEST || A - C <= 0.) // all ties
+		return alive[best];
+	T *= (k - 1) / (A - C);
+	if (T <= chi2Quantile(1. - TUNE_ALPHA, k - 1))
+		return alive[best];
+	const int df = (b - 1) * (k - 1);
+	const double threshold = studentQuantile(1. - TUNE_ALPHA / 2., df) * sqrt(2. * (b * A - sumR2) / df);
+	for (int a = 0; a < k; ++a) {
+		if (R[a] - R[best] > threshold)
+			candidates[alive[a]].alive = false;
+	}
+	return alive[best];
+}
+
+/////////////////////////////////////////////
+// Racing:
+/////////////////////////////////////////////
+
+// The same seed for all candidates of an instance, so that they are compared on the same random numbers.
+static double evaluate(const Parameters *params, int n_polygons, int instance)
+{
+	Engine engine;
+	initEngine(&engine, TUNE_SEED + instance, 0);
+	engine.params = *params;
+	engine.onImprovement = NULL;
+	Solution sol = init(n_polygons);
+	setTimeBudget(&engine, TUNE_BUDGET);
+	runOptimizer(&engine, &sol, INT_MAX);
+	const double cost = checkConfiguration(sol.polArray, n_polygons) ? sol.error : INFINITY;
+	clearEngine(&engine);
+	free(sol.polArray);
+	return cost;
+}
+
+static void* raceWorker(void *arg)
+{
+	Race *race = (Race*) arg;
+	int j;
+	while ((j = __atomic_fetch_add(&race->next, 1, __ATOMIC_RELAXED)) < race->n_jobs) {
+		Candidate *c = race->candidates + race->jobs[j];
+		c->costs[race->instance] = evaluate(&c->params, race->n_polygons, race->instance);
+	}
+	return NULL;
+}
+
+// Runs the alive candidates on a new instance, on all cores.
+static void runInstance(Race *race, int n_candidates)
+{
+	race->n_jobs = 0;
+	race->next = 0;
+	for (int c = 0; c < n_candidates; ++c) {
+		if (race->candidates[c].alive)
+			race->jobs[race->n_jobs++] = c;
+	}
+	const long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	const int wanted = cores < 1 ? 1 : cores < race->n_jobs ? (int) cores : race->n_jobs;
+	pthread_t threads[wanted];
+	int n_threads = 0;
+	for (; n_threads < wanted - 1; ++n_threads) {
+		if (pthread_create(threads + n_threads, NULL, raceWorker, race))
+			break; // the remaining work is done by the threads already running
+	}
+	raceWorker(race);
+	for (int k = 0; k < n_threads; ++k)
+		pthread_join(threads[k], NULL);
+}
+
+static int aliveCount(const Candidate *candidates, int n_candidates)
+{
+	int count = 0;
+	for (int c = 0; c < n_candidates; ++c)
+		count += candidates[c].alive;
+	return count;
+}
+
+// Mean ranks of the alive candidates, the others getting INFINITY.
+static void meanRanks(const Candidate *candidates, int n_candidates, int n_instances, double *mean)
+{
+	int alive[n_candidates], k = 0;
+	for (int c = 0; c < n_candidates; ++c) {
+		mean[c] = INFINITY;
+		if (candidates[c].alive)
+			alive[k++] = c;
+	}
+	double ranks[k];
+	for (int a = 0; a < k; ++a)
+		mean[alive[a]] = 0.;
+	for (int i = 0; i < n_instances; ++i) {
+		rankInstance(candidates, alive, k, i, ranks);
+		for (int a = 0; a < k; ++a)
+			mean[alive[a]] += ranks[a] / n_instances;
+	}
+}
+
+// irace-like: each iteration races new candidates along with the elites of the previous one, the first
+// iteration sampling them uniformly (the defaults being one of them), the next ones around the elites
+// with a spread halved at each iteration. Elites are raced again from scratch.
+static Parameters tuneSize(rng_type *rng, int n_polygons)
+{
+	Candidate candidates[TUNE_CANDIDATES];
+	int jobs[TUNE_CANDIDATES];
+	Race race = {n_polygons, 0, candidates, jobs, 0, 0};
+	Parameters elites[TUNE_ELITES];
+	int n_elites = 0;
+	double spread = 0.5;
+
+	for (int it = 0; it < TUNE_ITERATIONS; ++it, spread /= 2.) {
+		for (int c = 0; c < TUNE_CANDIDATES; ++c) {
+			candidates[c].alive = true;
+			if (c < n_elites)
+				candidates[c].params = elites[c];
+			else if (it == 0)
+				candidates[c].params = c == 0 ? defaultParameters() : sample(rng, NULL, 0.);
+			else
+				candidates[c].params = sample(rng, elites + rng_int(rng) % n_elites, spread);
+		}
+		int n_instances = 0;
+		while (n_instances < TUNE_MAX_SEEDS && aliveCount(candidates, TUNE_CANDIDATES) > 1) {
+			race.instance = n_instances++;
+			runInstance(&race, TUNE_CANDIDATES);
+			friedmanRace(candidates, TUNE_CANDIDATES, n_instances);
+		}
+
+		double mean[TUNE_CANDIDATES];
+		meanRanks(candidates, TUNE_CANDIDATES, n_instances, mean);
+		n_elites = 0;
+		while (n_elites < TUNE_ELITES) {
+			int best = -1;
+			for (int c = 0; c < TUNE_CANDIDATES; ++c) {
+				if (mean[c] < INFINITY && (best < 0 || mean[c] < mean[best]))
+					best = c;
+			}
+			if (best < 0)
+				break;
+			elites[n_elites++] = candidates[best].params;
+			mean[best] = INFINITY;
+		}
+		printf("n = %d, iteration %d: %d instances, %d survivors.\n", n_polygons, it, n_instances,
+			aliveCount(candidates, TUNE_CANDIDATES));
+	}
+	return elites[0];
+}
+
+bool tuneParameters(const int *sizes, int n_sizes, const char *path)
+{
+	rng_type rng;
+	rng_init(&rng, TUNE_SEED, 0);
+	Parameters best[n_sizes];
+	for (int s = 0; s < n_sizes; ++s) {
+		best[s] = tuneSize(&rng, sizes[s]);
+		const Parameters *p = best + s;
+		printf("Best for n = %d: optimizer %d, step size %g, rotation proba %g, neighbourhood %d, temperature %g, cooling %g\n\n",
+			sizes[s], p->optimizer, p->stepSize, p->rotationProba, p->neighbourhood, p->temperature, p->cooling);
+	}
+	return saveParameters(path, sizes, best, n_sizes);
+}
+
+/////////////////////////////////////////////
+// Parameters file:
+/////////////////////////////////////////////
+
+bool saveParameters(const char *path, const int *sizes, const Parameters *params, int n_sizes)
+{
+	FILE *file = fopen(path, "w");
+	if (!file) {
+		printf("Cannot open '%s' for writing.\n", path);
+		return false;
+	}
+	fprintf(file, "# n_polygons optimizer stepSize rotationProba neighbourhood temperature cooling\n");
+	for (int s = 0; s < n_sizes; ++s) {
+		const Parameters *p = params + s;
+		fprintf(file, "%d %d %.17g %.17g %d %.17g %.17g\n", sizes[s], p->optimizer, p->stepSize,
+			p->rotationProba, p->neighbourhood, p->temperature, p->cooling);
+	}
+	fclose(file);
+	return true;
+}
+
+// The line of the nearest number of polygons on a log scale is used, i.e each line stands for a class
+// of numbers of polygons. Other parameters are left untouched. Returns false if no line could be read.
+bool loadParameters(const char *path, int n_polygons, Parameters *params)
+{
+	FILE *file = fopen(path, "r");
+	if (!file)
+		return false;
+	char line[256];
+	double bestDistance = INFINITY;
+	while (fgets(line, sizeof(line), file)) {
+		if (line[0] == '#')
+			continue;
+		Parameters p = *params;
+		int n = 0, optimizer = 0;
+		if (sscanf(line, "%d %d %lf %lf %d %lf %lf", &n, &optimizer, &p.stepSize, &p.rotationProba,
+				&p.neighbourhood, &p.temperature, &p.cooling) != 7 || n <= 0 || optimizer < 0
+				|| optimizer >= N_OPTIMIZERS || p.neighbourhood <= 0) {
+			printf("Invalid line in '%s': %s", path, line);
+			continue;
+		}
+		p.optimizer = (Optimizer) optimizer;
+		const double dist = fabs(log((double) n / n_polygons));
+		if (dist < bestDistance) {
+			bestDistance = dist;
+			*params = p;
+		}
+	}
+	fclose(file);
+	return bestDistance < INFINITY;
+}
@@ -0,0 +1,13 @@
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <stdbool.h>
+#include "params.h"
+
+// Racing of search parameters, one race per number of polygons, the results being saved
+// in a parameters file: one line per number of polygons, see saveParameters().
+bool tuneParameters(const int *sizes, int n_sizes, const char *path);
+bool saveParameters(const char *path, const int *sizes, const Parameters *params, int n_sizes);
+bool loadParameters(const char *path, int n_polygons, Parameters *params);
+
+#endif